@@ -0,0 +1,111 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "VoxEngine.hpp"
+#include "Settings.hpp"
+#include "Logger.hpp"
+
+#include <iostream>
+#include <thread>
+
+/*
+// Headless check of the chunk lifecycle, no window or GL context is created.
+// Runs the chunk manager without meshing, and marks the chunk at the origin as uploaded by hand.
+// The camera moves away until that chunk is unloaded into the unload cache, then moves back and stays put.
+// The chunk comes back from the cache with its mesh, and has to be visible without the camera moving again
+// usage: ./lifecyclecheck
+*/
+
+constexpr int	MAX_UPDATES = 2000;
+
+// Updates the manager until done returns true, returns false if it takes more than MAX_UPDATES updates
+template <typename Function>
+static bool	updateUntil(ChunkManager &manager, Function done)
+{
+	for (int i = 0; i < MAX_UPDATES; ++i)
+	{
+		manager.update();
+		if (done())
+			return (true);
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	return (false);
+}
+
+static void	moveCamera(VoxEngine &engine, const mlm::ivec2 &chunkCoord)
+{
+	engine.getCamera().setPos(mlm::vec3(chunkCoord.x * static_cast<int>(CHUNK_SIZE_X) + 8.0f, 200.0f, chunkCoord.y * static_cast<int>(CHUNK_SIZE_Z) + 8.0f));
+}
+
+static bool	check(const std::string &name, bool ok)
+{
+	std::cout << name << (ok ? " OK" : " FAILED") << std::endl;
+	return (ok);
+}
+
+int	main(int argc, char **argv)
+{
+	(void)argc;
+	char		settingsPath[] = "settings.json";
+	char		*settingsArgv[] = {argv[0], settingsPath};
+	const mlm::ivec2	origin(0, 0);
+
+	// Only used for its chunk manager, the engine isn't run
+	std::unique_ptr<VoxEngine>	engine = std::make_unique<VoxEngine>();
+	ChunkManager				&manager = engine->getManager();
+	bool						ok = true;
+	try
+	{
+		Settings::loadPaths(2, settingsArgv);
+		ChunkManagerDTO	dto = Settings::loadChunkManager();
+		dto.renderDistance = 1;
+		dto.unloadMargin = 0;
+		dto.unloadCacheSize = 64;
+		dto.cacheMeshes = true;
+		// Nothing gets meshed, so nothing has to be uploaded to a GPU
+		dto.maxMesh = 0;
+		dto.meshCacheSize = 0;
+		dto.saveEdits = false;
+		dto.cacheChunks = false;
+		moveCamera(*engine, origin);
+		manager.init(dto);
+
+		std::shared_ptr<Chunk>	uploaded = nullptr;
+		ok = check("origin generated", updateUntil(manager, [&]() {
+			uploaded = manager.getChunk(origin);
+			return (uploaded && uploaded->getState() >= Chunk::GENERATED);
+		}));
+		if (ok)
+		{
+			// Stands in for meshing and uploading it
+			uploaded->setState(Chunk::UPLOADED);
+			moveCamera(*engine, mlm::ivec2(16, 0));
+			ok = check("origin unloaded", updateUntil(manager, [&]() {return (!manager.getChunk(origin));}));
+		}
+		if (ok)
+		{
+			// The camera doesn't move after this, so the render distance isn't walked again
+			moveCamera(*engine, origin);
+			ok = check("origin taken back from the unload cache", updateUntil(manager, [&]() {return (manager.getChunk(origin) == uploaded);}));
+		}
+		if (ok)
+		{
+			manager.update();
+			ok = check("origin visible", uploaded->getState() == Chunk::UPLOADED && manager.isChunkVisible(origin));
+		}
+
+		// It has no GPU buffers to free
+		if (uploaded)
+			uploaded->setState(Chunk::GENERATED);
+		uploaded = nullptr;
+		manager.cleanup();
+	}
+	catch(const std::exception& e)
+	{
+		Logger::error(e.what());
+		return (1);
+	}
+	return (ok ? 0 : 1);
+}
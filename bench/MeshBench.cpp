@@ -0,0 +1,160 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "VoxEngine.hpp"
+#include "Settings.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+/*
+// Headless meshing benchmark, no window or GL context is created.
+// Generates a square of chunks around the origin, then meshes every chunk that has all 4 neighbors.
+// Also counts the heap allocations made while meshing in the last iteration. The vertex buffers trade places
+// with the buffers of the meshes, so that is close to 0 once they have grown, but not exactly
+// usage: ./meshbench [radius] [iterations] [seed]
+*/
+
+static std::atomic<uint64_t>	allocations = 0;
+
+void	*operator new(size_t size)
+{
+	allocations.fetch_add(1, std::memory_order_relaxed);
+	void	*ptr = std::malloc(size ? size : 1);
+	if (!ptr)
+		throw std::bad_alloc();
+	return (ptr);
+}
+
+void	*operator new[](size_t size)
+{
+	return (::operator new(size));
+}
+
+void	operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void	operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void	operator delete(void *ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void	operator delete[](void *ptr, size_t) noexcept
+{
+	std::free(ptr);
+}
+
+struct MeshResult {
+	double	meanMs;
+	double	p99Ms;
+	double	quadsPerChunk;
+	double	allocationsPerMesh;
+};
+
+static MeshResult	benchMesh(ChunkManager &manager, bool greedy, std::vector<std::shared_ptr<Chunk>> &chunks, int size, int iterations)
+{
+	manager.setGreedyMeshing(greedy);
+
+	std::vector<double>	times;
+	uint64_t			quads = 0;
+	uint64_t			meshAllocations = 0;
+	times.reserve(static_cast<size_t>(iterations) * (size - 2) * (size - 2));
+	for (int i = 0; i < iterations; ++i)
+	{
+		quads = 0;
+		meshAllocations = 0;
+		for (int x = 1; x < size - 1; ++x)
+		{
+			for (int z = 1; z < size - 1; ++z)
+			{
+				ChunkNeighborhood	area = {
+					chunks[x * size + z]->getSnapshot(),
+					chunks[(x - 1) * size + z]->getSnapshot(),
+					chunks[(x + 1) * size + z]->getSnapshot(),
+					chunks[x * size + z - 1]->getSnapshot(),
+					chunks[x * size + z + 1]->getSnapshot(),
+				};
+				Chunk	&chunk = *chunks[x * size + z];
+				uint64_t	allocated = allocations.load(std::memory_order_relaxed);
+				auto		start = std::chrono::steady_clock::now();
+				chunk.mesh(area);
+				auto		end = std::chrono::steady_clock::now();
+				meshAllocations += allocations.load(std::memory_order_relaxed) - allocated;
+				times.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+				quads += (chunk.getMesh().get_vertices().size() + chunk.getWaterMesh().get_vertices().size()) / 4;
+			}
+		}
+	}
+
+	std::sort(times.begin(), times.end());
+	MeshResult	result;
+	double		total = 0.0;
+	for (double time : times)
+		total += time;
+	result.meanMs = total / static_cast<double>(times.size());
+	result.p99Ms = times[std::min(times.size() - 1, times.size() * 99 / 100)];
+	result.quadsPerChunk = static_cast<double>(quads) / static_cast<double>((size - 2) * (size - 2));
+	result.allocationsPerMesh = static_cast<double>(meshAllocations) / static_cast<double>((size - 2) * (size - 2));
+	return (result);
+}
+
+int	main(int argc, char **argv)
+{
+	int			radius = (argc > 1) ? std::atoi(argv[1]) : 4;
+	int			iterations = (argc > 2) ? std::atoi(argv[2]) : 5;
+	int			size = radius * 2 + 3;
+	char		settingsPath[] = "settings.json";
+	char		*settingsArgv[] = {argv[0], settingsPath};
+
+	// Only used for its chunk manager, the engine isn't run
+	std::unique_ptr<VoxEngine>	engine = std::make_unique<VoxEngine>();
+	try
+	{
+		Settings::loadPaths(2, settingsArgv);
+		TerrainGeneratorPtr	generator = std::make_shared<TerrainGenerator>(Settings::loadTerrainGenerator());
+		if (argc > 3)
+			generator->setSeed(std::strtoull(argv[3], nullptr, 10));
+
+		std::vector<std::shared_ptr<Chunk>>	chunks;
+		auto								start = std::chrono::steady_clock::now();
+		for (int x = 0; x < size; ++x)
+		{
+			for (int z = 0; z < size; ++z)
+			{
+				chunks.push_back(std::make_shared<Chunk>(mlm::ivec2(x - radius - 1, z - radius - 1), engine->getManager()));
+				chunks.back()->generate(generator);
+			}
+		}
+		double	generateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		std::cout << "seed " << generator->getSeed() << ", " << size * size << " chunks generated in " << generateMs << " ms, "
+			<< (size - 2) * (size - 2) << " meshed " << iterations << " times" << std::endl;
+		for (bool greedy : {false, true})
+		{
+			MeshResult	result = benchMesh(engine->getManager(), greedy, chunks, size, iterations);
+			std::cout << (greedy ? "greedy" : "naive ") << ": mean " << result.meanMs << " ms, p99 " << result.p99Ms
+				<< " ms, " << result.quadsPerChunk << " quads per chunk, " << result.allocationsPerMesh
+				<< " allocations per mesh" << std::endl;
+		}
+	}
+	catch(const std::exception& e)
+	{
+		Logger::error(e.what());
+		return (1);
+	}
+	return (0);
+}
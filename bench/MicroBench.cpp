@@ -0,0 +1,294 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "VoxEngine.hpp"
+#include "Settings.hpp"
+#include "Logger.hpp"
+#include "JobSystem.hpp"
+#include "Coords.hpp"
+#include "Frustum.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <latch>
+#include <random>
+
+/*
+// Microbenchmarks of the hot math and terrain functions, reported in ns per op.
+// Then a golden check: chunks are generated for fixed seeds with 1 and many threads, in different orders,
+// and the hashes of their blocks have to match each other and the hashes the shipped terrain.json gave
+// usage: ./microbench [iterations]
+*/
+
+using Clock = std::chrono::steady_clock;
+
+// Inputs are taken from a table of this size, so generating them isn't timed
+constexpr size_t	INPUT_COUNT = 4096;
+
+// Points per call of the batch functions
+constexpr size_t	BATCH_SIZE = 64;
+
+// Chunks of the golden check, a square around the origin so negative coordinates are covered
+constexpr int		GOLDEN_SIZE = 4;
+
+struct GoldenSeed {
+	uint64_t	seed;
+	uint64_t	hash;
+};
+
+// Hashes of the golden chunks for the terrain.json in the repo. They change when the terrain settings do,
+// only update them when a change to the generated terrain is intended
+static const std::vector<GoldenSeed>	GoldenSeeds = {
+	{4242, 0xd6a9601e68c94289ULL},
+	{1, 0x17deb618a8c552fcULL},
+	{123456, 0x3d4a361f8c78d394ULL},
+};
+
+// Calls op iterations / width times and prints the time per op, a call of op does width ops.
+// op returns a value that is added to sink, so the compiler can't drop the calls
+template <typename Op>
+static void	benchOp(const std::string &name, uint64_t iterations, uint64_t width, float &sink, Op op)
+{
+	uint64_t	calls = std::max<uint64_t>(iterations / width, 1);
+	float		sum = 0.0f;
+	auto		start = Clock::now();
+	for (uint64_t i = 0; i < calls; ++i)
+		sum += op(i % INPUT_COUNT);
+	double		ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+	sink += sum;
+	std::cout << name << std::string(std::max<size_t>(28, name.size() + 1) - name.size(), ' ')
+		<< ns / static_cast<double>(calls * width) << " ns/op" << std::endl;
+}
+
+static void	benchMath(uint64_t iterations, float &sink)
+{
+	std::mt19937							rng(42);
+	std::uniform_real_distribution<float>	coord(-10000.0f, 10000.0f);
+	std::uniform_real_distribution<float>	unit(-1.0f, 1.0f);
+	std::vector<mlm::vec3>					points(INPUT_COUNT);
+	std::vector<mlm::vec3>					normals(INPUT_COUNT);
+	std::vector<float>						ts(INPUT_COUNT);
+	for (size_t i = 0; i < INPUT_COUNT; ++i)
+	{
+		points[i] = mlm::vec3(coord(rng), unit(rng) * 128.0f + 128.0f, coord(rng));
+		normals[i] = mlm::normalize(mlm::vec3(unit(rng), unit(rng), unit(rng)));
+		ts[i] = unit(rng);
+	}
+
+	// Boxes the size of a chunk around the camera, about half of them are in view
+	Frustum					frustum;
+	frustum.update(mlm::perspective(ZOOM, 16.0f / 9.0f, 0.1f, 640.0f) * mlm::lookat(mlm::vec3(0.0f, 0.0f, -1.0f), mlm::vec3(0.0f, 1.0f, 0.0f)));
+	std::vector<AABB>		boxes(INPUT_COUNT);
+	std::vector<Plane>		planes(INPUT_COUNT);
+	for (size_t i = 0; i < INPUT_COUNT; ++i)
+	{
+		mlm::vec3	min(points[i].x / 20.0f, -128.0f, points[i].z / 20.0f);
+		boxes[i] = AABB(min, min + mlm::vec3(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z));
+		planes[i] = Plane(normals[i], ts[i] * 100.0f);
+	}
+
+	benchOp("Frustum::isBoxVisible", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(frustum.isBoxVisible(boxes[i])));
+	});
+	benchOp("AABB::getPositiveVertex", iterations, 1, sink, [&](size_t i) {
+		return (boxes[i].getPositiveVertex(normals[i]).x);
+	});
+	benchOp("Plane::distance", iterations, 1, sink, [&](size_t i) {
+		return (planes[i].distance(points[i]));
+	});
+	benchOp("getChunkCoord", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(getChunkCoord(mlm::ivec3(points[i])).x));
+	});
+	benchOp("getBlockChunkCoord", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(getBlockChunkCoord(mlm::ivec3(points[i])).z));
+	});
+	benchOp("getWorldCoord", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(getWorldCoord(points[i]).y));
+	});
+	benchOp("index3D", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(index3D(i & (CHUNK_SIZE_X - 1), i & (CHUNK_SIZE_Y - 1), (i >> 4) & (CHUNK_SIZE_Z - 1))));
+	});
+
+	Spline	spline({{-1.0f, 250.0f}, {-0.8f, 95.0f}, {-0.2f, 95.0f}, {0.0f, 108.0f}, {0.25f, 120.0f}, {0.55f, 160.0f}, {1.0f, 200.0f}});
+	benchOp("Spline::evaluate", iterations, 1, sink, [&](size_t i) {
+		return (spline.evaluate(ts[i]));
+	});
+	benchOp("Spline::evaluateExact", iterations, 1, sink, [&](size_t i) {
+		return (spline.evaluateExact(ts[i]));
+	});
+
+	Perlin	perlin(4242);
+	benchOp("Perlin::getValue 2D", iterations, 1, sink, [&](size_t i) {
+		return (perlin.getValue(points[i].x / 100.0f, points[i].z / 100.0f));
+	});
+	benchOp("Perlin::getValue 3D", iterations, 1, sink, [&](size_t i) {
+		return (perlin.getValue(points[i].x / 100.0f, points[i].y / 100.0f, points[i].z / 100.0f));
+	});
+
+	// Batch calls are timed per point
+	std::vector<float>	xs(INPUT_COUNT);
+	std::vector<float>	ys(INPUT_COUNT);
+	std::vector<float>	zs(INPUT_COUNT);
+	std::vector<float>	values(BATCH_SIZE);
+	for (size_t i = 0; i < INPUT_COUNT; ++i)
+	{
+		xs[i] = points[i].x / 100.0f;
+		ys[i] = points[i].y / 100.0f;
+		zs[i] = points[i].z / 100.0f;
+	}
+	benchOp("Perlin::getValues 2D", iterations, BATCH_SIZE, sink, [&](size_t i) {
+		size_t	start = i * BATCH_SIZE % INPUT_COUNT;
+		perlin.getValues(&xs[start], &zs[start], values.data(), BATCH_SIZE);
+		return (values[0]);
+	});
+	benchOp("Perlin::getValues 3D", iterations, BATCH_SIZE, sink, [&](size_t i) {
+		size_t	start = i * BATCH_SIZE % INPUT_COUNT;
+		perlin.getValues(&xs[start], &ys[start], &zs[start], values.data(), BATCH_SIZE);
+		return (values[0]);
+	});
+}
+
+static void	benchTerrain(const TerrainGenerator &generator, uint64_t iterations, float &sink)
+{
+	std::mt19937			rng(42);
+	std::uniform_int_distribution<int>	coord(-10000, 10000);
+	std::vector<mlm::ivec3>	positions(INPUT_COUNT);
+	for (mlm::ivec3 &pos : positions)
+		pos = mlm::ivec3(coord(rng), coord(rng) & (CHUNK_SIZE_Y - 1), coord(rng));
+
+	benchOp("getTerrainHeight", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(generator.getTerrainHeight(positions[i])));
+	});
+	benchOp("getBlock", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(generator.getBlock(positions[i]).getType()));
+	});
+	benchOp("isCave", iterations, 1, sink, [&](size_t i) {
+		return (static_cast<float>(generator.isCave(positions[i])));
+	});
+
+	// Per column and per block, over the same areas Chunk::generate asks for
+	std::array<TerrainColumn, CHUNK_SIZE_X * CHUNK_SIZE_Z>	columns;
+	benchOp("getColumns (per column)", iterations, columns.size(), sink, [&](size_t i) {
+		generator.getColumns(mlm::ivec2(positions[i].x, positions[i].z), mlm::ivec2(CHUNK_SIZE_X, CHUNK_SIZE_Z), columns.data());
+		return (static_cast<float>(columns[0].height));
+	});
+	std::array<Block, CHUNK_SIZE_Y>	blocks;
+	benchOp("getBlocks (per block)", iterations, blocks.size(), sink, [&](size_t i) {
+		generator.getBlocks(columns[i % columns.size()], CaveLattice(), mlm::ivec3(positions[i].x, 0, positions[i].z), blocks.data(), blocks.size());
+		return (static_cast<float>(blocks[CHUNK_SIZE_Y / 2].getType()));
+	});
+}
+
+// FNV-1a over the block types of a chunk, z, then x, then y
+static uint64_t	hashChunk(const ChunkSnapshot &snapshot)
+{
+	uint64_t	hash = 0xCBF29CE484222325ULL;
+	for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+		for (uint64_t x = 0; x < CHUNK_SIZE_X; ++x)
+			for (uint64_t y = 0; y < CHUNK_SIZE_Y; ++y)
+				hash = (hash ^ snapshot.getBlock(x, y, z).getType()) * 0x100000001B3ULL;
+	return (hash);
+}
+
+// Generates the golden chunks in order on threads threads, 0 generates them on this thread.
+// Returns the hash of every chunk, in the order of the chunk positions
+static std::vector<uint64_t>	generateGolden(ChunkManager &manager, TerrainGeneratorPtr generator, int threads, const std::vector<size_t> &order)
+{
+	std::vector<std::shared_ptr<Chunk>>	chunks;
+	for (int x = 0; x < GOLDEN_SIZE; ++x)
+		for (int z = 0; z < GOLDEN_SIZE; ++z)
+			chunks.push_back(std::make_shared<Chunk>(mlm::ivec2(x - GOLDEN_SIZE / 2, z - GOLDEN_SIZE / 2), manager));
+
+	if (threads == 0)
+	{
+		for (size_t i : order)
+			chunks[i]->generate(generator);
+	}
+	else
+	{
+		JobSystem	jobs;
+		std::latch	done(order.size());
+		jobs.start(threads);
+		for (size_t i : order)
+		{
+			jobs.submit([&, i]() {
+				chunks[i]->generate(generator);
+				done.count_down();
+			});
+		}
+		done.wait();
+		jobs.stop();
+	}
+
+	std::vector<uint64_t>	hashes;
+	for (const std::shared_ptr<Chunk> &chunk : chunks)
+		hashes.push_back(hashChunk(*chunk->getSnapshot()));
+	return (hashes);
+}
+
+// Checks that the golden chunks don't depend on the thread count or the generation order, and match GoldenSeeds
+static bool	checkGolden(ChunkManager &manager, const TerrainGeneratorDTO &dto)
+{
+	int					threads = std::max(static_cast<int>(std::thread::hardware_concurrency()), 2);
+	std::vector<size_t>	order(GOLDEN_SIZE * GOLDEN_SIZE);
+	for (size_t i = 0; i < order.size(); ++i)
+		order[i] = i;
+	std::vector<size_t>	reversed(order.rbegin(), order.rend());
+	std::vector<size_t>	shuffled = order;
+	std::shuffle(shuffled.begin(), shuffled.end(), std::mt19937(42));
+
+	bool	ok = true;
+	for (const GoldenSeed &golden : GoldenSeeds)
+	{
+		TerrainGeneratorPtr		generator = std::make_shared<TerrainGenerator>(dto);
+		generator->setSeed(golden.seed);
+		std::vector<uint64_t>	expected = generateGolden(manager, generator, 0, order);
+		bool					deterministic = (generateGolden(manager, generator, 1, reversed) == expected)
+			&& (generateGolden(manager, generator, threads, shuffled) == expected)
+			&& (generateGolden(manager, generator, threads, reversed) == expected);
+
+		uint64_t	hash = 0xCBF29CE484222325ULL;
+		for (uint64_t chunkHash : expected)
+			hash = (hash ^ chunkHash) * 0x100000001B3ULL;
+		bool		matches = (hash == golden.hash);
+		std::cout << "golden seed " << golden.seed << ": hash " << std::hex << hash << std::dec
+			<< (matches ? " OK" : " FAILED") << ", 1 and " << threads << " threads in 3 orders "
+			<< (deterministic ? "OK" : "FAILED") << std::endl;
+		ok = ok && matches && deterministic;
+	}
+	return (ok);
+}
+
+int	main(int argc, char **argv)
+{
+	uint64_t	iterations = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1 << 22;
+	char		settingsPath[] = "settings.json";
+	char		*settingsArgv[] = {argv[0], settingsPath};
+
+	// Only used for its chunk manager, the engine isn't run
+	std::unique_ptr<VoxEngine>	engine = std::make_unique<VoxEngine>();
+	try
+	{
+		Settings::loadPaths(2, settingsArgv);
+		TerrainGeneratorDTO	dto = Settings::loadTerrainGenerator();
+		TerrainGenerator	generator(dto);
+
+		// Keeps the compiler from dropping the calls
+		float	sink = 0.0f;
+		std::cout << iterations << " iterations" << std::endl;
+		benchMath(iterations, sink);
+		benchTerrain(generator, iterations / 16, sink);
+		std::cout << "checksum " << sink << std::endl;
+		if (!checkGolden(engine->getManager(), dto))
+			return (1);
+	}
+	catch(const std::exception& e)
+	{
+		Logger::error(e.what());
+		return (1);
+	}
+	return (0);
+}
@@ -0,0 +1,369 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "Chunk.hpp"
+#include "Settings.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+/*
+// Noise sampling benchmark. Samples raw Perlin noise and the terrain noise functions over the
+// same grid of blocks chunk generation walks, and reports samples per second.
+// Also checks that the density graph gives the same blocks as getBlock, and reports the speed
+// and error of sampling the cave noise on a lattice and of the baked splines
+// usage: ./noisebench [chunks] [seed]
+*/
+
+using Clock = std::chrono::steady_clock;
+
+// Calls sample for every block of a chunks x chunks square, height blocks high, and returns samples/s.
+// Samplers are fetched per chunk, like Chunk::generate does
+template <typename Sampler>
+static double	benchNoise(const TerrainGenerator &generator, int chunks, int height, float &sink, Sampler sample)
+{
+	auto	start = Clock::now();
+	for (int chunkX = 0; chunkX < chunks; ++chunkX)
+	{
+		for (int chunkZ = 0; chunkZ < chunks; ++chunkZ)
+		{
+			const perlinSamplers	&samplers = generator.getSamplers();
+			for (int x = chunkX * CHUNK_SIZE_X; x < (chunkX + 1) * static_cast<int>(CHUNK_SIZE_X); ++x)
+				for (int z = chunkZ * CHUNK_SIZE_Z; z < (chunkZ + 1) * static_cast<int>(CHUNK_SIZE_Z); ++z)
+					for (int y = 0; y < height; ++y)
+						sink += sample(samplers, x, y, z);
+		}
+	}
+	double	seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return (static_cast<double>(chunks * chunks) * CHUNK_SIZE_X * CHUNK_SIZE_Z * height / seconds);
+}
+
+// Same as benchNoise, but calls sample once per row of CHUNK_SIZE_X blocks along x
+template <typename Sampler>
+static double	benchRows(const TerrainGenerator &generator, int chunks, int height, float &sink, Sampler sample)
+{
+	float	row[CHUNK_SIZE_X];
+	auto	start = Clock::now();
+	for (int chunkX = 0; chunkX < chunks; ++chunkX)
+	{
+		for (int chunkZ = 0; chunkZ < chunks; ++chunkZ)
+		{
+			const perlinSamplers	&samplers = generator.getSamplers();
+			for (int z = chunkZ * CHUNK_SIZE_Z; z < (chunkZ + 1) * static_cast<int>(CHUNK_SIZE_Z); ++z)
+			{
+				for (int y = 0; y < height; ++y)
+				{
+					sample(samplers, chunkX * static_cast<int>(CHUNK_SIZE_X), y, z, row);
+					for (float value : row)
+						sink += value;
+				}
+			}
+		}
+	}
+	double	seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	return (static_cast<double>(chunks * chunks) * CHUNK_SIZE_X * CHUNK_SIZE_Z * height / seconds);
+}
+
+// Generates every block of the chunks with the per block getBlock and with the column API, which have to match
+static bool	checkColumns(const TerrainGenerator &generator, int chunks)
+{
+	TerrainGenerator		exact = generator;
+	exact.setLatticeStep(0);
+	uint64_t				mismatches = 0;
+	uint64_t				hash = 0xCBF29CE484222325ULL;
+	double					blockSeconds = 0.0;
+	double					columnSeconds = 0.0;
+	int						size = chunks * static_cast<int>(CHUNK_SIZE_X);
+	for (int z = 0; z < size; ++z)
+	{
+		std::vector<TerrainColumn>	columns(size);
+		auto						start = Clock::now();
+		exact.getColumns(mlm::ivec2(0, z), mlm::ivec2(size, 1), columns.data());
+		columnSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+		for (int x = 0; x < size; ++x)
+		{
+			std::array<Block, CHUNK_SIZE_Y>	expected;
+			std::array<Block, CHUNK_SIZE_Y>	blocks;
+			start = Clock::now();
+			for (uint64_t y = 0; y < CHUNK_SIZE_Y; ++y)
+				expected[y] = exact.getBlock(mlm::ivec3(x, y, z));
+			blockSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+			start = Clock::now();
+			exact.getBlocks(columns[x], CaveLattice(), mlm::ivec3(x, 0, z), blocks.data(), blocks.size());
+			columnSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			for (uint64_t y = 0; y < CHUNK_SIZE_Y; ++y)
+			{
+				mismatches += (blocks[y].getType() != expected[y].getType());
+				hash = (hash ^ expected[y].getType()) * 0x100000001B3ULL;
+			}
+		}
+	}
+	double	blocks = static_cast<double>(size) * size * CHUNK_SIZE_Y;
+	std::cout << "getBlock:       " << blocks / blockSeconds << " blocks/s" << std::endl;
+	std::cout << "column API:     " << blocks / columnSeconds << " blocks/s" << std::endl;
+	std::cout << "column check " << (mismatches ? "FAILED" : "OK") << ": " << mismatches << " mismatches in "
+		<< chunks * chunks << " chunks, block hash " << std::hex << hash << std::dec << std::endl;
+	return (mismatches == 0);
+}
+
+struct ChunkTerrain {
+	std::vector<TerrainColumn>	columns;
+	CaveLattice					caves;
+	std::vector<Block>			blocks;
+	int							maxHeight;
+};
+
+// Same steps as Chunk::generate, without the sections
+static void	generateTerrain(const TerrainGenerator &generator, const mlm::ivec3 &pos, ChunkTerrain &out)
+{
+	out.columns.resize(CHUNK_SIZE_X * CHUNK_SIZE_Z);
+	out.blocks.resize(CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z);
+	generator.getColumns(mlm::ivec2(pos.x, pos.z), mlm::ivec2(CHUNK_SIZE_X, CHUNK_SIZE_Z), out.columns.data());
+	out.maxHeight = generator.getSeaLevel();
+	for (const TerrainColumn &column : out.columns)
+		out.maxHeight = std::max(out.maxHeight, column.height);
+	out.caves = generator.getCaveLattice(pos, mlm::ivec3(CHUNK_SIZE_X, out.maxHeight + 1, CHUNK_SIZE_Z));
+	for (uint64_t i = 0; i < out.columns.size(); ++i)
+	{
+		mlm::ivec3	columnPos = pos + mlm::ivec3(i % CHUNK_SIZE_X, 0, i / CHUNK_SIZE_X);
+		generator.getBlocks(out.columns[i], out.caves, columnPos, &out.blocks[i * CHUNK_SIZE_Y], CHUNK_SIZE_Y);
+	}
+}
+
+// Generates the chunks without a lattice and with a few lattice steps, and reports the time per chunk
+// and how far the lattice is off from sampling every block
+static void	reportLattice(const TerrainGenerator &generator, int chunks)
+{
+	struct LatticeResult {
+		int			step;
+		double		seconds = 0.0;
+		int			maxHeightDiff = 0;
+		float		maxCaveDiff = 0.0f;
+		uint64_t	changedBlocks = 0;
+	};
+	std::vector<LatticeResult>	results = {{0}, {2}, {4}, {8}};
+	std::vector<TerrainGenerator>	generators(results.size(), generator);
+	for (size_t i = 0; i < results.size(); ++i)
+		generators[i].setLatticeStep(results[i].step);
+	const DensityProgram			&program = generator.getDensityProgram();
+	size_t							noiseCount = program.getBlockNoiseCount();
+
+	for (int chunkX = 0; chunkX < chunks; ++chunkX)
+	{
+		for (int chunkZ = 0; chunkZ < chunks; ++chunkZ)
+		{
+			mlm::ivec3		pos(chunkX * CHUNK_SIZE_X, 0, chunkZ * CHUNK_SIZE_Z);
+			ChunkTerrain	exact;
+			for (size_t i = 0; i < results.size(); ++i)
+			{
+				ChunkTerrain	terrain;
+				auto			start = Clock::now();
+				generateTerrain(generators[i], pos, terrain);
+				results[i].seconds += std::chrono::duration<double>(Clock::now() - start).count();
+				if (i == 0)
+				{
+					exact = std::move(terrain);
+					continue ;
+				}
+
+				for (uint64_t b = 0; b < exact.blocks.size(); ++b)
+					results[i].changedBlocks += (exact.blocks[b].getType() != terrain.blocks[b].getType());
+				for (uint64_t c = 0; c < exact.columns.size(); ++c)
+					results[i].maxHeightDiff = std::max(results[i].maxHeightDiff, std::abs(exact.columns[c].height - terrain.columns[c].height));
+
+				// Compare the interpolated cave noises to the exact noises, over every block a cave can be in
+				for (uint64_t c = 0; c < exact.columns.size(); ++c)
+				{
+					int								x = pos.x + static_cast<int>(c % CHUNK_SIZE_X);
+					int								z = pos.z + static_cast<int>(c / CHUNK_SIZE_X);
+					std::vector<float>				xs(exact.maxHeight, static_cast<float>(x));
+					std::vector<float>				ys(exact.maxHeight);
+					std::vector<float>				zs(exact.maxHeight, static_cast<float>(z));
+					std::vector<std::vector<float>>	values(noiseCount, std::vector<float>(exact.maxHeight));
+					std::vector<std::vector<float>>	lattice(noiseCount, std::vector<float>(exact.maxHeight));
+					std::vector<float *>			latticeValues;
+					for (int y = 0; y < exact.maxHeight; ++y)
+						ys[y] = static_cast<float>(y + 1);
+					for (size_t n = 0; n < noiseCount; ++n)
+					{
+						program.getBlockNoise(n, xs.data(), ys.data(), zs.data(), values[n].data(), values[n].size());
+						latticeValues.push_back(lattice[n].data());
+					}
+					terrain.caves.getColumn(x, z, 1, latticeValues.data(), exact.maxHeight);
+					for (size_t n = 0; n < noiseCount; ++n)
+						for (int y = 0; y < exact.maxHeight; ++y)
+							results[i].maxCaveDiff = std::max(results[i].maxCaveDiff, std::abs(lattice[n][y] - values[n][y]));
+				}
+			}
+		}
+	}
+
+	double	chunkCount = static_cast<double>(chunks * chunks);
+	double	exactMs = results[0].seconds * 1000.0 / chunkCount;
+	std::cout << "lattice exact: " << exactMs << " ms per chunk" << std::endl;
+	for (size_t i = 1; i < results.size(); ++i)
+	{
+		const LatticeResult	&result = results[i];
+		double				ms = result.seconds * 1000.0 / chunkCount;
+		std::cout << "lattice " << result.step << ":     " << ms << " ms per chunk, " << exactMs / ms << "x, max height diff "
+			<< result.maxHeightDiff << ", max cave noise diff "
+			<< result.maxCaveDiff << ", "
+			<< 100.0 * static_cast<double>(result.changedBlocks) / (chunkCount * CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z)
+			<< "% blocks changed" << std::endl;
+	}
+}
+
+/*
+// Compares the baked splines to the exact curves, and times generation with both.
+// The spline share is the spline values evaluated while generating times the measured cost of one value,
+// timing every batch inside generation would cost more than the splines themselves
+*/
+static void	reportSplines(const TerrainGenerator &generator, const TerrainGeneratorDTO &dto, int chunks)
+{
+	const int	samples = 1 << 20;
+	double		exactSampleSeconds = 0.0;
+	double		bakedSampleSeconds = 0.0;
+	std::vector<std::pair<std::string, Spline>>	splines = {
+		{"continentalness", dto.continentalness.spline}, {"cave", dto.cave.spline}, {"sand", dto.sand.spline}};
+	for (auto &[name, spline] : splines)
+	{
+		spline.setResolution(static_cast<uint64_t>(dto.splineResolution));
+		float	maxError = 0.0f;
+		float	sink = 0.0f;
+		// Noise values stay within -1 and 1
+		auto	start = Clock::now();
+		for (int i = 0; i < samples; ++i)
+			sink += spline.evaluateExact(-1.0f + 2.0f * static_cast<float>(i) / samples);
+		double	exactSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+		start = Clock::now();
+		for (int i = 0; i < samples; ++i)
+			sink += spline.evaluate(-1.0f + 2.0f * static_cast<float>(i) / samples);
+		double	bakedSeconds = std::chrono::duration<double>(Clock::now() - start).count();
+		for (int i = 0; i < samples; ++i)
+		{
+			float	t = -1.0f + 2.0f * static_cast<float>(i) / samples;
+			maxError = std::max(maxError, std::abs(spline.evaluate(t) - spline.evaluateExact(t)));
+		}
+		std::cout << "spline " << name << ": resolution " << spline.getResolution() << ", max error " << maxError
+			<< ", exact " << samples / exactSeconds << "/s, baked " << samples / bakedSeconds << "/s (" << sink << ")" << std::endl;
+		exactSampleSeconds += exactSeconds / samples / static_cast<double>(splines.size());
+		bakedSampleSeconds += bakedSeconds / samples / static_cast<double>(splines.size());
+	}
+
+	TerrainGenerator	exact = generator;
+	exact.setSplineResolution(0);
+	double				exactSeconds = 0.0;
+	double				bakedSeconds = 0.0;
+	uint64_t			exactEvaluations = 0;
+	uint64_t			bakedEvaluations = 0;
+	uint64_t			changedBlocks = 0;
+	for (int chunkX = 0; chunkX < chunks; ++chunkX)
+	{
+		for (int chunkZ = 0; chunkZ < chunks; ++chunkZ)
+		{
+			mlm::ivec3		pos(chunkX * CHUNK_SIZE_X, 0, chunkZ * CHUNK_SIZE_Z);
+			ChunkTerrain	exactTerrain;
+			ChunkTerrain	bakedTerrain;
+			uint64_t		evaluations = Spline::getBatchEvaluations();
+			auto			start = Clock::now();
+			generateTerrain(exact, pos, exactTerrain);
+			exactSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			exactEvaluations += Spline::getBatchEvaluations() - evaluations;
+			evaluations = Spline::getBatchEvaluations();
+			start = Clock::now();
+			generateTerrain(generator, pos, bakedTerrain);
+			bakedSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			bakedEvaluations += Spline::getBatchEvaluations() - evaluations;
+			for (uint64_t b = 0; b < exactTerrain.blocks.size(); ++b)
+				changedBlocks += (exactTerrain.blocks[b].getType() != bakedTerrain.blocks[b].getType());
+		}
+	}
+	double	chunkCount = static_cast<double>(chunks * chunks);
+	double	exactShare = static_cast<double>(exactEvaluations) * exactSampleSeconds / exactSeconds;
+	double	bakedShare = static_cast<double>(bakedEvaluations) * bakedSampleSeconds / bakedSeconds;
+	std::cout << "splines exact: " << exactSeconds * 1000.0 / chunkCount << " ms per chunk, spline share " << 100.0 * exactShare
+		<< "%, baked: " << bakedSeconds * 1000.0 / chunkCount << " ms per chunk, spline share " << 100.0 * bakedShare << "%, "
+		<< static_cast<double>(bakedEvaluations) / chunkCount << " spline values per chunk, time saved "
+		<< 100.0 * (exactSeconds - bakedSeconds) / exactSeconds << "%, "
+		<< 100.0 * static_cast<double>(changedBlocks) / (chunkCount * CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z) << "% blocks changed" << std::endl;
+}
+
+int	main(int argc, char **argv)
+{
+	int		chunks = (argc > 1) ? std::atoi(argv[1]) : 8;
+	char	settingsPath[] = "settings.json";
+	char	*settingsArgv[] = {argv[0], settingsPath};
+
+	try
+	{
+		Settings::loadPaths(2, settingsArgv);
+		TerrainGeneratorDTO	dto = Settings::loadTerrainGenerator();
+		TerrainGenerator	generator(dto);
+		if (argc > 2)
+			generator.setSeed(std::strtoull(argv[2], nullptr, 10));
+
+		// Keeps the compiler from dropping the samples
+		float	sink = 0.0f;
+		std::cout << "seed " << generator.getSeed() << ", " << chunks << "x" << chunks << " chunks" << std::endl;
+		std::cout << "perlin 2D:      " << benchNoise(generator, chunks, 1, sink, [&](const perlinSamplers &samplers, int x, int, int z) {
+			return (samplers.height.getValue(x / dto.continentalness.zoom, z / dto.continentalness.zoom));
+		}) << " samples/s" << std::endl;
+		std::cout << "perlin 3D:      " << benchNoise(generator, chunks, 64, sink, [&](const perlinSamplers &samplers, int x, int y, int z) {
+			return (samplers.cave1.getValue(x / dto.cave.zoom, y / dto.cave.zoom, z / dto.cave.zoom));
+		}) << " samples/s" << std::endl;
+		std::cout << "perlin 2D rows: " << benchRows(generator, chunks, 1, sink, [&](const perlinSamplers &samplers, int x, int, int z, float *out) {
+			float	xs[CHUNK_SIZE_X];
+			float	zs[CHUNK_SIZE_X];
+			for (uint64_t i = 0; i < CHUNK_SIZE_X; ++i)
+			{
+				xs[i] = (x + static_cast<int>(i)) / dto.continentalness.zoom;
+				zs[i] = z / dto.continentalness.zoom;
+			}
+			samplers.height.getValues(xs, zs, out, CHUNK_SIZE_X);
+		}) << " samples/s" << std::endl;
+		std::cout << "perlin 3D rows: " << benchRows(generator, chunks, 64, sink, [&](const perlinSamplers &samplers, int x, int y, int z, float *out) {
+			float	xs[CHUNK_SIZE_X];
+			float	ys[CHUNK_SIZE_X];
+			float	zs[CHUNK_SIZE_X];
+			for (uint64_t i = 0; i < CHUNK_SIZE_X; ++i)
+			{
+				xs[i] = (x + static_cast<int>(i)) / dto.cave.zoom;
+				ys[i] = y / dto.cave.zoom;
+				zs[i] = z / dto.cave.zoom;
+			}
+			samplers.cave1.getValues(xs, ys, zs, out, CHUNK_SIZE_X);
+		}) << " samples/s" << std::endl;
+		std::cout << "height:         " << benchNoise(generator, chunks, 1, sink, [&](const perlinSamplers &, int x, int, int z) {
+			return (static_cast<float>(generator.getTerrainHeight(mlm::ivec2(x, z))));
+		}) << " samples/s" << std::endl;
+		std::cout << "height rows:    " << benchRows(generator, chunks, 1, sink, [&](const perlinSamplers &, int x, int, int z, float *out) {
+			int	heights[CHUNK_SIZE_X];
+			generator.getTerrainHeights(mlm::ivec2(x, z), heights, CHUNK_SIZE_X);
+			for (uint64_t i = 0; i < CHUNK_SIZE_X; ++i)
+				out[i] = static_cast<float>(heights[i]);
+		}) << " samples/s" << std::endl;
+		std::cout << "cave:           " << benchNoise(generator, chunks, 64, sink, [&](const perlinSamplers &, int x, int y, int z) {
+			return (static_cast<float>(generator.isCave(mlm::ivec3(x, y, z))));
+		}) << " samples/s" << std::endl;
+		std::cout << "checksum " << sink << std::endl;
+		const DensityProgram	&program = generator.getDensityProgram();
+		std::cout << "density program: " << program.getColumnInstructionCount() << " column, " << program.getBlockInstructionCount()
+			<< " block instructions, " << program.getRegisterCount() << " registers" << std::endl;
+		if (!checkColumns(generator, chunks))
+			return (1);
+		reportLattice(generator, chunks);
+		reportSplines(generator, dto, chunks);
+	}
+	catch(const std::exception& e)
+	{
+		Logger::error(e.what());
+		return (1);
+	}
+	return (0);
+}
@@ -0,0 +1,196 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "VoxEngine.hpp"
+#include "ChunkStorage.hpp"
+#include "Settings.hpp"
+#include "Logger.hpp"
+#include "JobSystem.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <latch>
+#include <sys/resource.h>
+#include <unistd.h>
+
+/*
+// Headless chunk pipeline benchmark, no window or GL context is created.
+// Generates a (size + 2)^2 square of chunks on the job system, then meshes the inner size^2 chunks.
+// The generated chunks are saved to region files in a temporary directory and loaded back,
+// with read and with mmap, to compare loading from disk to generating.
+// Terrain and meshing settings come from settings.json, like the engine
+// usage: ./ft_vox_bench [size] [threads] [seed]
+*/
+
+struct PhaseResult {
+	double	wallMs;
+	double	meanMs;
+	double	p99Ms;
+};
+
+using Clock = std::chrono::steady_clock;
+
+static double	toMs(Clock::duration duration)
+{
+	return (std::chrono::duration<double, std::milli>(duration).count());
+}
+
+// Runs work for every index on the job system, and times each call
+static PhaseResult	runPhase(JobSystem &jobs, size_t count, const std::function<void(size_t)> &work)
+{
+	std::vector<double>	times(count);
+	std::latch			done(count);
+	auto				start = Clock::now();
+	for (size_t i = 0; i < count; ++i)
+	{
+		jobs.submit([&, i]() {
+			auto	jobStart = Clock::now();
+			work(i);
+			times[i] = toMs(Clock::now() - jobStart);
+			done.count_down();
+		});
+	}
+	done.wait();
+
+	PhaseResult	result;
+	result.wallMs = toMs(Clock::now() - start);
+	double		total = 0.0;
+	for (double time : times)
+		total += time;
+	std::sort(times.begin(), times.end());
+	result.meanMs = total / static_cast<double>(count);
+	result.p99Ms = times[std::min(count - 1, count * 99 / 100)];
+	return (result);
+}
+
+// Loads every chunk from storage, returns how many didn't match the generated chunk
+static uint64_t	loadChunks(ChunkStorage &storage, const std::vector<std::shared_ptr<Chunk>> &chunks)
+{
+	std::atomic<uint64_t>	mismatches = 0;
+	std::latch				done(chunks.size());
+	for (const std::shared_ptr<Chunk> &chunk : chunks)
+	{
+		ChunkSnapshotPtr	generated = chunk->getSnapshot();
+		storage.read(chunk->getChunkPos(), [&, generated](ChunkSnapshotPtr loaded) {
+			if (!loaded || ChunkStorage::encode(*loaded) != ChunkStorage::encode(*generated))
+				mismatches++;
+			done.count_down();
+		});
+	}
+	done.wait();
+	return (mismatches);
+}
+
+static void	printPhase(const std::string &name, const PhaseResult &result, size_t count)
+{
+	std::cout << name << ": " << static_cast<double>(count) / (result.wallMs / 1000.0) << " chunks/s, mean "
+		<< result.meanMs << " ms, p99 " << result.p99Ms << " ms per chunk" << std::endl;
+}
+
+int	main(int argc, char **argv)
+{
+	int			size = (argc > 1) ? std::atoi(argv[1]) : 16;
+	int			threads = (argc > 2) ? std::atoi(argv[2]) : static_cast<int>(std::thread::hardware_concurrency());
+	int			paddedSize = size + 2;
+	char		settingsPath[] = "settings.json";
+	char		*settingsArgv[] = {argv[0], settingsPath};
+
+	// Only used for its chunk manager, the engine isn't run
+	std::unique_ptr<VoxEngine>	engine = std::make_unique<VoxEngine>();
+	try
+	{
+		Settings::loadPaths(2, settingsArgv);
+		ChunkManagerDTO		managerDto = Settings::loadChunkManager();
+		TerrainGeneratorPtr	generator = std::make_shared<TerrainGenerator>(Settings::loadTerrainGenerator());
+		if (argc > 3)
+			generator->setSeed(std::strtoull(argv[3], nullptr, 10));
+		ChunkManager		&manager = engine->getManager();
+		manager.setGreedyMeshing(managerDto.greedyMeshing);
+
+		std::vector<std::shared_ptr<Chunk>>	chunks;
+		for (int x = 0; x < paddedSize; ++x)
+			for (int z = 0; z < paddedSize; ++z)
+				chunks.push_back(std::make_shared<Chunk>(mlm::ivec2(x - paddedSize / 2, z - paddedSize / 2), manager));
+
+		JobSystem	jobs;
+		jobs.start(std::max(threads, 1));
+		std::cout << "seed " << generator->getSeed() << ", " << size << "x" << size << " chunks, " << jobs.getThreadCount()
+			<< " threads, " << (managerDto.greedyMeshing ? "greedy" : "naive") << " meshing" << std::endl;
+
+		PhaseResult	generated = runPhase(jobs, chunks.size(), [&](size_t i) {
+			chunks[i]->generate(generator);
+		});
+
+		std::vector<uint64_t>	vertexCounts(size * size);
+		PhaseResult	meshed = runPhase(jobs, size * size, [&](size_t i) {
+			size_t				x = i / size + 1;
+			size_t				z = i % size + 1;
+			ChunkNeighborhood	area = {
+				chunks[x * paddedSize + z]->getSnapshot(),
+				chunks[(x - 1) * paddedSize + z]->getSnapshot(),
+				chunks[(x + 1) * paddedSize + z]->getSnapshot(),
+				chunks[x * paddedSize + z - 1]->getSnapshot(),
+				chunks[x * paddedSize + z + 1]->getSnapshot(),
+			};
+			Chunk	&chunk = *chunks[x * paddedSize + z];
+			chunk.mesh(area);
+			vertexCounts[i] = chunk.getMesh().get_vertices().size() + chunk.getWaterMesh().get_vertices().size();
+		});
+		jobs.stop();
+
+		std::filesystem::path	savePath = std::filesystem::temp_directory_path() / ("ft_vox_bench_" + std::to_string(getpid()));
+		std::filesystem::remove_all(savePath);
+		ChunkStorage	storage;
+		storage.start(savePath.string() + "/", false);
+		auto			saveStart = Clock::now();
+		for (const std::shared_ptr<Chunk> &chunk : chunks)
+			storage.write(chunk->getChunkPos(), chunk->getSnapshot());
+		storage.flush();
+		double			saveMs = toMs(Clock::now() - saveStart);
+		// Reads of a fresh storage go through the region files, the page cache is warm for both
+		storage.stop();
+		storage.start(savePath.string() + "/", false);
+		auto			loadStart = Clock::now();
+		uint64_t		mismatches = loadChunks(storage, chunks);
+		double			loadMs = toMs(Clock::now() - loadStart);
+		storage.stop();
+		storage.start(savePath.string() + "/", true);
+		auto			mmapStart = Clock::now();
+		mismatches += loadChunks(storage, chunks);
+		double			mmapMs = toMs(Clock::now() - mmapStart);
+		storage.stop();
+		std::filesystem::remove_all(savePath);
+
+		uint64_t	vertices = 0;
+		for (uint64_t count : vertexCounts)
+			vertices += count;
+		rusage		usage;
+		getrusage(RUSAGE_SELF, &usage);
+
+		printPhase("generate", generated, chunks.size());
+		printPhase("mesh    ", meshed, size * size);
+		// Every worker has its own lock, so with enough jobs per worker almost none of them should be contended
+		std::cout << "jobs    : " << jobs.getStealCount() << " stolen, " << jobs.getContendedCount() << " of "
+			<< jobs.getLockCount() << " worker locks contended" << std::endl;
+		std::cout << "save    : " << static_cast<double>(chunks.size()) / (saveMs / 1000.0) << " chunks/s, "
+			<< storage.getWrittenBytes() / chunks.size() << " bytes per chunk" << std::endl;
+		std::cout << "load    : " << static_cast<double>(chunks.size()) / (loadMs / 1000.0) << " chunks/s read, "
+			<< static_cast<double>(chunks.size()) / (mmapMs / 1000.0) << " chunks/s mmap, "
+			<< generated.wallMs / loadMs << "x generate" << std::endl;
+		if (mismatches > 0)
+			throw std::runtime_error(std::to_string(mismatches) + " loaded chunks don't match the generated ones");
+		std::cout << "pipeline: " << static_cast<double>(size * size) / ((generated.wallMs + meshed.wallMs) / 1000.0) << " chunks/s" << std::endl;
+		std::cout << "vertices: " << vertices / (size * size) << " per chunk" << std::endl;
+		std::cout << "peak RSS: " << usage.ru_maxrss / 1024 << " MiB" << std::endl;
+	}
+	catch(const std::exception& e)
+	{
+		Logger::error(e.what());
+		return (1);
+	}
+	return (0);
+}
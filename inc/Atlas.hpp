@@ -9,6 +9,7 @@ Created on: 27/08/2025
 #include "Block.hpp"
 
 #include <unordered_map>
+#include <array>
 
 struct AtlasDTO {
 	enum class SIDE {
@@ -32,12 +33,12 @@ class Atlas {
 
 		bool													load();
 		void													bind();
-		const std::vector<mlm::vec2>							&getOffset(Block::Type blockType);
-		const std::vector<mlm::vec2>							&getCorners();
+		int														getTile(Block::Type blockType, int side) const;
+		float													getTilePixelWidth() const;
 		void													del();
 
 	private:
-		std::unordered_map<Block::Type, std::vector<mlm::vec2>>	_offsets;
-		std::vector<mlm::vec2>									_uvCorners;
+		std::array<std::array<int, 6>, Block::TYPE_COUNT>		_tiles = {};
+		float													_tilePixelWidth = 1.0f;
 		Tex2d													_texture; // make bind function
 };
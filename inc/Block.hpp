@@ -7,15 +7,24 @@ Created on: 06/08/2025
 
 #include "glu/gl-utils.hpp"
 
+#include <cstdint>
+
 class Block {
 	public:
-		enum Type {
+		enum Type : uint8_t {
 			AIR,
 			DIRT,
 			GRASS,
 			STONE,
 			WATER,
 			SAND,
+			TYPE_COUNT,
+		};
+
+		// Per type state, so a block only has to store its type
+		struct Properties {
+			bool	enabled;
+			bool	transparent;
 		};
 
 		Block();
@@ -25,12 +34,12 @@ class Block {
 		Block		&operator=(const Block &src);
 
 		bool		getEnabled() const;
-		void		setEnabled(bool enabled);
 		bool		getTransparent() const;
 		Type		getType() const;
 		void		setType(Type type);
 
 	private:
+		static const Properties	_properties[TYPE_COUNT];
+
 		Type		_type = AIR;
-		bool		_isEnabled = false;
 };
@@ -0,0 +1,55 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "ChunkSection.hpp"
+
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+/*
+// Recycles the block arrays of chunk sections, so loading and unloading chunks doesn't keep
+// allocating and freeing them. Arrays are kept for reuse up to a high-water mark, above it they
+// are freed again. With huge pages the arrays are carved out of 2 MiB slabs, which stay resident
+*/
+class BlockPool {
+	public:
+		struct Stats {
+			uint64_t	hits;
+			uint64_t	misses;
+			// Bytes held by the pool, slabs and freed arrays kept for reuse
+			size_t		residentBytes;
+		};
+
+		static constexpr size_t	ARRAY_BYTES = SECTION_VOLUME * sizeof(Block);
+		static constexpr size_t	SLAB_BYTES = 2 * 1024 * 1024;
+
+		// Until it is configured the pool keeps nothing, every array is allocated and freed right away
+		static void				configure(size_t highWaterBytes, bool hugePages);
+		// Returns uninitialized memory for ARRAY_BYTES bytes
+		static void				*allocate();
+		static void				release(void *array);
+		// Frees the pooled arrays that aren't in a slab
+		static void				clear();
+		static Stats			getStats();
+
+	private:
+		static std::mutex			_mtx;
+		static std::vector<void *>	_free;
+		static std::vector<uint8_t *>	_slabs;
+		// Arrays left in the newest slab
+		static uint8_t				*_slabNext;
+		static uint8_t				*_slabEnd;
+		static size_t				_highWater;
+		static size_t				_residentBytes;
+		static bool					_hugePages;
+		static uint64_t				_hits;
+		static uint64_t				_misses;
+
+		static void					*_allocateFromSlab();
+		static bool					_isInSlab(const void *array);
+};
@@ -8,9 +8,11 @@ Created on: 06/08/2025
 #include "Block.hpp"
 #include "ChunkManager.hpp"
 #include "ChunkMesh.hpp"
+#include "ChunkSection.hpp"
 #include "TerrainGenerator.hpp"
 
 #include <array>
+#include <memory>
 #include <atomic>
 #include <mutex>
 #include <math.h>
@@ -18,8 +20,35 @@ Created on: 06/08/2025
 constexpr uint64_t	CHUNK_SIZE_X = 16; // MUST BE POWER OF 2
 constexpr uint64_t	CHUNK_SIZE_Y = 256;
 constexpr uint64_t	CHUNK_SIZE_Z = 16; // MUST BE POWER OF 2
+constexpr uint64_t	CHUNK_SECTION_COUNT = CHUNK_SIZE_Y / SECTION_SIZE;
+
+static_assert(CHUNK_SIZE_X == SECTION_SIZE && CHUNK_SIZE_Z == SECTION_SIZE, "Sections have to span the whole chunk horizontally");
+static_assert(CHUNK_SIZE_Y % SECTION_SIZE == 0, "Chunk height has to be a multiple of the section size");
 
 class ChunkManager;
+struct MeshScratch;
+
+/*
+// Immutable view of the blocks of a chunk. Edits publish a new snapshot that shares
+// every section that didn't change, so readers never have to lock
+*/
+struct ChunkSnapshot {
+	std::array<std::shared_ptr<const ChunkSection>, CHUNK_SECTION_COUNT>	sections;
+	uint64_t																version = 0;
+
+	Block																	getBlock(uint64_t x, uint64_t y, uint64_t z) const;
+};
+
+using ChunkSnapshotPtr = std::shared_ptr<const ChunkSnapshot>;
+
+// Snapshots of a chunk and its 4 horizontal neighbors, a neighbor is nullptr if it isn't loaded
+struct ChunkNeighborhood {
+	ChunkSnapshotPtr	center;
+	ChunkSnapshotPtr	west;
+	ChunkSnapshotPtr	east;
+	ChunkSnapshotPtr	north;
+	ChunkSnapshotPtr	south;
+};
 
 class Chunk {
 	public:
@@ -36,16 +65,38 @@ class Chunk {
 		Chunk(const mlm::ivec2 &chunkPos, ChunkManager &manager);
 		~Chunk();
 
+		// Makes a recycled chunk a new LOADED one at chunkPos, keeping the capacity of its vertex buffers
+		void															reset(const mlm::ivec2 &chunkPos);
+
 		void															generate(TerrainGeneratorPtr generator);
+		// Takes over the blocks of a chunk loaded from disk instead of generating them
+		void															load(ChunkSnapshotPtr snapshot);
 		void															draw(Shader &shader);
 		void															drawWater(Shader &shader);
 		void															mesh();
+		// Meshes the center snapshot of area, without looking up neighbors in the manager
+		void															mesh(const ChunkNeighborhood &area);
 		void															upload();
+		// Frees the GPU buffers of an uploaded mesh. The vertices are kept so it can be uploaded again,
+		// if they were freed after uploading the chunk goes back to GENERATED to be meshed again
+		void															releaseMesh();
+		// For a chunk nothing references anymore. Dropping its blocks can happen on any thread,
+		// freeing its GPU buffers only on the main thread. The vertex buffers keep their capacity
+		void															releaseBlocks();
+		void															releaseGpu();
 
 		Block															getBlock(const mlm::ivec3 &blockChunkCoord);
 		bool															setBlock(const mlm::ivec3 &blockChunkCoord, Block block);
 		Block::Type														getBlockType(const mlm::ivec3 &blockChunkCoord);
+		ChunkSnapshotPtr												getSnapshot() const;
+		uint64_t														getBlockMemory();
+		// Vertices the CPU side buffers of both meshes have room for
+		uint64_t														getVertexCapacity();
+		// Bytes of vertices uploaded to the GPU
+		uint64_t														getGpuMemory();
 		std::pair<mlm::vec3 &, mlm::vec3 &>								getMinMax();
+		ChunkMesh														&getMesh();
+		ChunkMesh														&getWaterMesh();
 		mlm::ivec2														getChunkPos();
 		mlm::ivec3														getWorldPos();
 		void															setState(const State state);
@@ -54,13 +105,20 @@ class Chunk {
 		std::atomic<bool>												_busy = false;
 		std::atomic<bool>												_dirty = false;
 		std::atomic<bool>												_readyToUpload = false;
+		// Snapshot version that is on disk, the chunk only has to be saved again once it changed
+		std::atomic<uint64_t>											_savedVersion = 0;
 
 	private:
-		void															_pushBackVertexWrapper(std::vector<Vertex> &vertices, const Vertex &vert);
-		void															_addCube(std::vector<Vertex> &vertices, const mlm::ivec3 &ipos);
+		void															_pushBackVertexWrapper(std::vector<ChunkVertex> &vertices, const mlm::ivec3 &pos, int face, Block::Type type);
+		void															_addQuad(std::vector<ChunkVertex> &vertices, int face, const mlm::ivec3 &ipos, const mlm::ivec3 &size, Block::Type type);
+		void															_addCube(std::vector<ChunkVertex> &vertices, const mlm::ivec3 &ipos, Block::Type type, uint8_t faces);
+		uint64_t														_findVisibleFaces(const ChunkNeighborhood &area, MeshScratch &scratch);
+		uint64_t														_meshNaive(const ChunkNeighborhood &area, MeshScratch &scratch);
+		uint64_t														_meshGreedy(const ChunkNeighborhood &area, MeshScratch &scratch);
 
 		std::mutex														_busyMtx;
-		std::array<Block, CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z>	_blocks;
+		std::atomic<ChunkSnapshotPtr>									_snapshot;
+		// Only serializes writers, readers load _snapshot
 		std::mutex														_blockMtx;
 		ChunkMesh														_mesh;
 		ChunkMesh														_waterMesh;
@@ -72,6 +130,6 @@ class Chunk {
 		mlm::vec3														_min = INFINITY;
 		mlm::vec3														_max = -INFINITY;
 
-		State															_state = UNLOADED;
-		std::mutex														_stateMtx;
+		// Read by the main thread while a worker moves the chunk to its next state
+		std::atomic<State>												_state = UNLOADED;
 };
@@ -0,0 +1,63 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "glu/gl-utils.hpp"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+class Chunk;
+
+/*
+// Loaded chunks in a fixed square of slots around the camera, a chunk goes in the slot at its
+// coordinate modulo the grid size. Moving the camera reuses the slots of the chunks left behind,
+// so lookups and memory don't depend on how far the camera has travelled.
+// A slot can still hold a chunk that is waiting to be unloaded, every lookup checks the coordinate of
+// the chunk in the slot. Slots are atomic, workers look up neighbors without taking a lock
+*/
+class ChunkGrid {
+	public:
+		ChunkGrid();
+		~ChunkGrid();
+
+		// Makes room for every chunk within radius of a center chunk, and clears the grid
+		void									init(int radius);
+
+		// Returns nullptr if the chunk isn't in the grid
+		std::shared_ptr<Chunk>					get(const mlm::ivec2 &chunkPos) const;
+		// Whether the slot of chunkPos is empty, or already holds that chunk
+		bool									isFree(const mlm::ivec2 &chunkPos) const;
+		// Returns false if the slot is taken by another chunk. Only called on the main thread
+		bool									insert(std::shared_ptr<Chunk> chunk);
+		// Empties the slot of chunkPos if it holds that chunk. Only called on the main thread
+		void									erase(const mlm::ivec2 &chunkPos);
+		void									clear();
+
+		// Calls function with every chunk in the grid
+		template <typename Function>
+		void									forEach(Function function) const
+		{
+			for (const std::atomic<std::shared_ptr<Chunk>> &slot : _slots)
+			{
+				std::shared_ptr<Chunk>	chunk = slot.load();
+				if (chunk)
+					function(chunk);
+			}
+		}
+
+		size_t									getCount() const;
+		int										getSize() const;
+
+	private:
+		std::vector<std::atomic<std::shared_ptr<Chunk>>>	_slots;
+		int										_size = 0;
+		std::atomic<size_t>						_count = 0;
+
+		const std::atomic<std::shared_ptr<Chunk>>	&_getSlot(const mlm::ivec2 &chunkPos) const;
+		std::atomic<std::shared_ptr<Chunk>>		&_getSlot(const mlm::ivec2 &chunkPos);
+};
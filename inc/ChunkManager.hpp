@@ -7,29 +7,40 @@ Created on: 19/08/2025
 
 #include "glu/gl-utils.hpp"
 #include "Chunk.hpp"
+#include "ChunkGrid.hpp"
+#include "ChunkPool.hpp"
+#include "ChunkStorage.hpp"
+#include "EditJournal.hpp"
 #include "Expected.hpp"
 #include "TerrainGenerator.hpp"
+#include "JobSystem.hpp"
+#include "MeshCache.hpp"
 
 #include <unordered_map>
+#include <list>
 #include <set>
 #include <memory>
 #include <thread>
 #include <atomic>
 #include <queue>
 #include <functional>
+#include <chrono>
 
 struct ivec2Hash {
 	size_t	operator()(const mlm::ivec2 &v) const
 	{
-		// convert 2 32 bit ints to 1 64 bit long
-		size_t ret = v.x;
-		ret += (static_cast<size_t>(v.y) << 32);
+		// convert 2 32 bit ints to 1 64 bit long, a negative x can't sign extend into y
+		size_t ret = static_cast<uint32_t>(v.x);
+		ret |= (static_cast<size_t>(static_cast<uint32_t>(v.y)) << 32);
 		return (ret);
 	};
 };
 
 class Chunk;
 class VoxEngine;
+struct ChunkSnapshot;
+
+using ChunkSnapshotPtr = std::shared_ptr<const ChunkSnapshot>;
 
 struct ChunkManagerDTO {
 	float	renderDistance;
@@ -37,6 +48,38 @@ struct ChunkManagerDTO {
 	float	maxLoad;
 	float	maxGenerate;
 	float	maxMesh;
+	bool	greedyMeshing;
+	// Blocks changed by the player are kept in a journal in savePath, and set again after generating
+	bool		saveEdits;
+	std::string	savePath;
+	// Whole chunks are saved to region files in savePath when they are unloaded, and loaded from there instead of generated
+	bool		cacheChunks;
+	bool		mmapReads;
+	// Chunks are only unloaded once they are unloadMargin chunks outside of render distance
+	float		unloadMargin;
+	// Unloaded chunks kept in memory, the least recently unloaded ones are dropped first
+	float		unloadCacheSize;
+	// Whether unloaded chunks keep their mesh on the GPU
+	bool		cacheMeshes;
+	// MiB of meshes kept for chunks that get meshed again with the same blocks, 0 disables it
+	float		meshCacheSize;
+	// Meshes dropped from the mesh cache are written to savePath instead, up to MiB of meshSpillSize
+	bool		meshCacheSpill;
+	float		meshSpillSize;
+	// Unused chunks and MiB of block arrays kept for reuse, block arrays are taken from huge pages with hugePages
+	float		chunkPoolSize;
+	float		blockPoolSize;
+	bool		hugePages;
+	// Uploaded meshes only keep their draw count, a chunk that lost its GPU buffers has to be meshed again
+	bool		freeMeshVertices;
+};
+
+struct ChunkCacheStats {
+	uint64_t	hits;
+	uint64_t	misses;
+	// Hits that didn't have to be generated, and the ones that didn't have to be meshed either
+	uint64_t	regenerationsAvoided;
+	uint64_t	remeshesAvoided;
 };
 
 class ChunkManager {
@@ -45,6 +88,7 @@ class ChunkManager {
 		struct ChunkTask {
 			std::weak_ptr<Chunk>				ptr;
 			enum class Type {GENERATE, MESH}	type;
+			mlm::ivec2							chunkPos;
 		};
 
 		ChunkManager(VoxEngine &engine);
@@ -72,6 +116,10 @@ class ChunkManager {
 
 		bool																isBlockTransparent(const mlm::vec3 &blockCoord);
 		bool																isBlockTransparent(const mlm::ivec3 &blockCoord);
+		ChunkSnapshotPtr													getChunkSnapshot(const mlm::ivec2 &chunkCoord);
+		std::shared_ptr<Chunk>												getChunk(const mlm::ivec2 &chunkCoord);
+		// Whether the chunk is uploaded and in render distance, so it's drawn when it's in the view frustum
+		bool																isChunkVisible(const mlm::ivec2 &chunkCoord) const;
 
 		Expected<mlm::ivec3, bool>											castRayIncluding();
 		Expected<mlm::ivec3, bool>											castRayExcluding();
@@ -80,40 +128,91 @@ class ChunkManager {
 
 		void																setUpdateVisibility();
 
+		bool																getGreedyMeshing() const;
+		bool																getFreeMeshVertices() const;
+		void																setGreedyMeshing(bool greedyMeshing);
+		void																addMeshStats(uint64_t faceCount, uint64_t quadCount, uint64_t microseconds);
+		void																logMeshStats();
+		void																logMemoryStats();
+		void																logCacheStats();
+		ChunkCacheStats														getCacheStats() const;
+
 		VoxEngine															&getEngine();
+		EditJournal															&getEditJournal();
+		MeshCache															&getMeshCache();
 
 	private:
-		std::unordered_map<mlm::ivec2, std::shared_ptr<Chunk>, ivec2Hash>	_chunks;
-		std::mutex															_chunksMtx;
+		// Loaded chunks, sized to everything within the unload margin of the camera chunk
+		ChunkGrid															_chunks;
+		ChunkPool															_chunkPool;
+		// Chunks waiting for their next step, what is over budget stays for the next update
 		std::vector<mlm::ivec2>												_chunkLoadList = {};
 		std::vector<std::shared_ptr<Chunk>>									_chunkGenerateList = {};
 		std::vector<std::shared_ptr<Chunk>>									_chunkMeshList = {};
 		std::vector<std::shared_ptr<Chunk>>									_chunkUnloadList = {};
 		std::vector<std::shared_ptr<Chunk>>									_chunkUploadList = {};
 		std::vector<std::shared_ptr<Chunk>>									_chunkVisibleList = {};
+		// Set when chunks were uploaded or unloaded, the visible list is filtered and sorted again
+		bool																_visibleChanged = false;
 		std::vector<std::shared_ptr<Chunk>>									_chunkRenderList = {};
 		std::vector<std::shared_ptr<Chunk>>									_chunkShadowRenderList = {};
 
-		// Multithreading stuff
-		std::deque<ChunkTask>												_queue;
-		std::mutex															_queueMtx;
-		std::vector<std::thread>											_threads;
+		// Chunks that finished a task on a worker or the I/O thread, drained by the main thread every update
+		std::vector<mlm::ivec2>												_completed;
+		std::mutex															_completedMtx;
+
+		// Multithreading stuff, tasks wait in the deques of the workers ordered by _getTaskPriority
+		JobSystem															_jobs;
 		int																	_threadCount = {};
-		std::atomic<bool>													_running = true;
+		// Edits and region files of the current seed, only running if saveEdits and cacheChunks are set
+		EditJournal															_journal;
+		ChunkStorage														_storage;
+		bool																_saveEdits = false;
+		bool																_cacheChunks = false;
+		std::string															_savePath = {};
+		bool																_mmapReads = false;
 
 		VoxEngine															&_engine;
 
 		std::atomic<TerrainGeneratorPtr>									_generator;
 
+		// Walks every chunk in render distance once, only needed when the camera entered another chunk
 		std::atomic<bool>													_updateVisibility = true;
 		mlm::ivec2															_cameraChunkCoord = {2147483647};
 		int																	_renderDistance = {};
 		mlm::ivec2															_renderMin = {0};
 		mlm::ivec2															_renderMax = {0};
+		mlm::ivec2															_unloadMin = {0};
+		mlm::ivec2															_unloadMax = {0};
+		int																	_unloadMargin = 0;
+
+		// Recently unloaded chunks, most recent first. Only used on the main thread
+		std::list<std::shared_ptr<Chunk>>									_unloadedChunks;
+		std::unordered_map<mlm::ivec2, std::list<std::shared_ptr<Chunk>>::iterator, ivec2Hash>	_unloadedIndex;
+		size_t																_unloadCacheSize = 0;
+		bool																_cacheMeshes = false;
+		ChunkCacheStats														_cacheStats = {};
+		uint64_t															_loggedHits = 0;
+		MeshCache															_meshCache;
+		uint64_t															_loggedMeshHits = 0;
 
 		int																	_maxLoad;
 		int																	_maxGenerate;
 		int																	_maxMesh;
+		bool																_greedyMeshing = false;
+		bool																_freeMeshVertices = false;
+
+		// Visible block faces and the quads they were meshed into, to compare meshing modes
+		std::atomic<uint64_t>												_meshedFaces = 0;
+		std::atomic<uint64_t>												_meshedQuads = 0;
+		std::atomic<uint64_t>												_meshedChunks = 0;
+		std::atomic<uint64_t>												_meshMicroseconds = 0;
+		uint64_t															_loggedQuads = 0;
+		size_t																_loggedChunks = 0;
+
+		// Set when the camera jumps more than 1 chunk, until the chunk it landed in is uploaded
+		bool																_waitingForTerrain = false;
+		std::chrono::steady_clock::time_point								_jumpTime;
 
 		void																_updateLoadList();
 		void																_updateGenerateList();
@@ -126,12 +225,38 @@ class ChunkManager {
 
 		// Update the chunk coordinates of the camera if they have changed
 		void																_updateCameraChunkCoord();
+		void																_updateTimeToVisible();
+		void																_sortVisibleList();
+
+		// Takes the chunks finished since the last update, and moves them on to their next step
+		void																_drainCompleted();
+		void																_pushCompleted(const mlm::ivec2 &chunkCoord);
+		// Puts a chunk in the list of its next step, based on its state
+		void																_dispatchChunk(const std::shared_ptr<Chunk> &chunk);
+		// Dispatches a chunk, and its neighbors that were waiting on it to be generated
+		void																_onChunkChanged(const std::shared_ptr<Chunk> &chunk);
+		// A chunk can be meshed once its 4 neighbors are generated
+		bool																_isMeshReady(const std::shared_ptr<Chunk> &chunk);
+		void																_queueMeshIfReady(const mlm::ivec2 &chunkCoord);
+		bool																_isInRenderRange(const mlm::ivec2 &chunkCoord) const;
+		bool																_isInUnloadRange(const mlm::ivec2 &chunkCoord) const;
 
 		bool																_loadChunk(const mlm::ivec2 &chunkCoord);
 		void																_unloadChunk(std::shared_ptr<Chunk> &chunk);
+		// Queues the blocks of a chunk for writing if they changed since it was last saved
+		void																_saveChunk(std::shared_ptr<Chunk> &chunk);
+		void																_saveAll();
+		// Marks a loaded or cached chunk for remeshing
+		void																_markDirty(const mlm::ivec2 &chunkCoord);
+		void																_clearUnloadCache();
+		void																_startSaving();
+		void																_stopSaving();
 
-		void																_ThreadRoutine();
+		void																_runTask(const ChunkTask &task);
 		void																_addToQueue(std::shared_ptr<Chunk> &chunk, ChunkTask::Type type);
-		ChunkTask															_popFromQueue();
+		// Lower runs first
+		size_t																_getTaskPriority(const mlm::ivec2 &chunkPos);
+		void																_reprioritizeTasks();
+		void																_cancelTasks();
 
 };
@@ -6,24 +6,52 @@ Created on: 19/08/2025
 #pragma once
 
 #include "glu/gl-utils.hpp"
+#include "ChunkVertex.hpp"
 
 class ChunkMesh {
 	public:
 		ChunkMesh();
 		~ChunkMesh();
-		ChunkMesh(const std::vector<Vertex> &vertices);
-
-		void					draw(Shader &shader);
-
-		void					setup_mesh();
-		std::vector<Vertex>		&get_vertices();
-
-		void					del();
+		ChunkMesh(const std::vector<ChunkVertex> &vertices);
+
+		void						draw(Shader &shader);
+
+		void						setup_mesh();
+		const std::vector<ChunkVertex>	&get_vertices() const;
+		// Hands out the vertices to share, like to the mesh cache. The mesh never changes them after this
+		ChunkVerticesPtr			share_vertices();
+		// Shares vertices with whatever else holds them, like the mesh cache
+		void						set_vertices(ChunkVerticesPtr vertices);
+		// Takes vertices over without copying them. vertices gets the old buffer of the mesh back
+		// to build the next mesh in, or an empty one when it was shared
+		void						swap_vertices(std::vector<ChunkVertex> &vertices);
+		// Empties the mesh, its buffer keeps its capacity when it wasn't shared
+		void						clear_vertices();
+		// Frees the CPU copy of an uploaded mesh, it can be drawn but not uploaded again
+		void						free_vertices();
+		bool						has_vertices() const;
+		// Size of the vertex buffer on the GPU, 0 once it's deleted
+		size_t						get_gpu_bytes() const;
+
+		void						del();
+
+		static void					delQuadIndices();
 
 	private:
-		std::vector<Vertex>		_vertices;
-
-		VAO						_vao;
-		VBO						_vbo;
+		// nullptr when empty
+		ChunkVerticesPtr			_vertices;
+		// Whether anything else got _vertices, if not the mesh can change them in place
+		bool						_verticesShared = false;
+		bool						_verticesFreed = false;
+		GLsizei						_indexCount = 0;
+
+		// One index buffer shared by every chunk mesh, quads are 4 vertices drawn as 2 triangles
+		static GLuint				_quadIbo;
+		static size_t				_quadCapacity;
+		static void					_reserveQuadIndices(size_t quadCount);
+		std::vector<ChunkVertex>	*_ownedVertices();
+
+		VAO							_vao;
+		VBO							_vbo;
 
 };
@@ -0,0 +1,63 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "glu/gl-utils.hpp"
+
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+class Chunk;
+class ChunkManager;
+
+/*
+// Recycles chunks that are no longer used instead of deleting them. A recycled chunk keeps
+// the capacity of its vertex buffers, so meshing it again doesn't grow them from nothing.
+// The last reference to a chunk can be dropped on any thread, so released chunks only drop their blocks
+// and wait for the main thread to free their GPU buffers. At most highWater chunks are kept, the rest are deleted
+*/
+class ChunkPool {
+	public:
+		struct Stats {
+			uint64_t	hits;
+			uint64_t	misses;
+			// Chunks that are pooled or waiting for collect
+			size_t		pooledChunks;
+			// Bytes the pooled chunks still hold: the chunk itself, its vertex buffers and its GPU buffers until collect
+			size_t		residentBytes;
+		};
+
+		ChunkPool();
+		~ChunkPool();
+
+		void									init(size_t highWater);
+		// Returns a chunk at chunkPos in state LOADED, a recycled one if there is one. Only called on the main thread
+		std::shared_ptr<Chunk>					acquire(const mlm::ivec2 &chunkPos, ChunkManager &manager);
+		// Frees the GPU buffers of the chunks released since the last call, then pools them. Only called on the main thread
+		void									collect();
+		// Deletes every pooled chunk, their GPU buffers included. Only called on the main thread
+		void									clear();
+
+		Stats									getStats() const;
+
+	private:
+		// Shared with the deleters of the chunks handed out, a chunk released after the pool is gone is deleted
+		struct Shared {
+			std::mutex							mtx;
+			std::vector<std::unique_ptr<Chunk>>	free;
+			// Released by their last reference, they can still have GPU buffers
+			std::vector<std::unique_ptr<Chunk>>	released;
+			size_t								highWater = 0;
+		};
+
+		std::shared_ptr<Shared>					_shared;
+		std::atomic<uint64_t>					_hits = 0;
+		std::atomic<uint64_t>					_misses = 0;
+
+		static size_t							_residentBytes(Chunk &chunk);
+};
@@ -0,0 +1,59 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "Block.hpp"
+
+#include <array>
+#include <memory>
+
+constexpr uint64_t	SECTION_SIZE = 16; // MUST BE POWER OF 2
+constexpr uint64_t	SECTION_VOLUME = SECTION_SIZE * SECTION_SIZE * SECTION_SIZE;
+
+/*
+// A 16x16x16 part of a chunk. As long as every block in it has the same type the section
+// only stores that type, the block array is allocated once a different block is set
+*/
+class ChunkSection {
+	public:
+		ChunkSection();
+		ChunkSection(Block block);
+		ChunkSection(const ChunkSection &src);
+		ChunkSection(ChunkSection &&src) = default;
+		~ChunkSection();
+
+		ChunkSection	&operator=(const ChunkSection &src);
+		ChunkSection	&operator=(ChunkSection &&src) = default;
+
+		// Coordinates are local to the section
+		Block			getBlock(uint64_t x, uint64_t y, uint64_t z) const;
+		void			setBlock(uint64_t x, uint64_t y, uint64_t z, Block block);
+		// Sets the SECTION_SIZE blocks of the column at x and z, blocks[0] is the bottom one
+		void			setColumn(uint64_t x, uint64_t z, const Block *blocks);
+		// Copies the types of the SECTION_SIZE blocks in the row at y and z to dst
+		void			copyRowTypes(uint64_t y, uint64_t z, uint8_t *dst) const;
+
+		bool			isUniform() const;
+		Block			getUniformBlock() const;
+		// Frees the block array if every block in it has the same type
+		void			compact();
+		uint64_t		getMemory() const;
+
+	private:
+		using Blocks = std::array<Block, SECTION_VOLUME>;
+		// Gives the block array back to the BlockPool
+		struct BlocksDeleter {
+			void	operator()(Blocks *blocks) const;
+		};
+
+		std::unique_ptr<Blocks, BlocksDeleter>	_blocks;
+		Block					_uniform;
+
+		static uint64_t			_index(uint64_t x, uint64_t y, uint64_t z);
+		// Block arrays come from the BlockPool, filled with block
+		static Blocks			*_newBlocks(Block block);
+		static Blocks			*_newBlocks(const Blocks &src);
+};
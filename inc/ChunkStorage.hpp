@@ -0,0 +1,98 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "glu/gl-utils.hpp"
+#include "RegionFile.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+struct ChunkSnapshot;
+
+using ChunkSnapshotPtr = std::shared_ptr<const ChunkSnapshot>;
+
+/*
+// Saves chunks to region files and loads them back on a dedicated I/O thread.
+// Reads and writes are queued and handled in batches, one batch per region file.
+// Every chunk is compressed by run length encoding its block columns
+*/
+class ChunkStorage {
+	public:
+		// Called with the loaded snapshot, nullptr if the chunk couldn't be loaded. Called on the I/O thread,
+		// or on the thread calling stop for reads that were still queued
+		using ReadCallback = std::function<void(ChunkSnapshotPtr snapshot)>;
+
+		ChunkStorage();
+		~ChunkStorage();
+
+		// Stores the region files in path, with mmapReads the region files are mapped instead of read
+		void								start(const std::string &path, bool mmapReads);
+		// Writes everything still queued, reads that haven't started yet get nullptr
+		void								stop();
+		bool								isRunning() const;
+
+		// False if the chunk is known not to be saved. Only checks region files that are already open,
+		// a chunk of a region that isn't open yet may be saved, read answers nullptr if it isn't
+		bool								mayContain(const mlm::ivec2 &chunkPos);
+		void								read(const mlm::ivec2 &chunkPos, ReadCallback callback);
+		// A newer write of the same chunk replaces the queued one
+		void								write(const mlm::ivec2 &chunkPos, ChunkSnapshotPtr snapshot);
+		// Blocks until every queued write is in its region file
+		void								flush();
+
+		static std::vector<uint8_t>			encode(const ChunkSnapshot &snapshot);
+		// Returns nullptr if data isn't a valid chunk
+		static ChunkSnapshotPtr				decode(const uint8_t *data, size_t size);
+
+		uint64_t							getReadCount() const;
+		uint64_t							getWriteCount() const;
+		uint64_t							getWrittenBytes() const;
+
+	private:
+		struct ReadRequest {
+			mlm::ivec2			chunkPos;
+			ReadCallback		callback;
+			// Set when the chunk was still waiting to be written, it doesn't have to go through the file
+			ChunkSnapshotPtr	snapshot;
+		};
+
+		std::string							_path;
+		bool								_mmapReads = false;
+
+		std::thread							_thread;
+		std::atomic<bool>					_running = false;
+		std::mutex							_queueMtx;
+		std::condition_variable				_wake;
+		std::condition_variable				_flushed;
+		std::vector<ReadRequest>			_reads;
+		// Keyed by _key, snapshots waiting to be written and the ones being written right now
+		std::unordered_map<uint64_t, std::pair<mlm::ivec2, ChunkSnapshotPtr>>	_writes;
+		std::unordered_map<uint64_t, std::pair<mlm::ivec2, ChunkSnapshotPtr>>	_writing;
+
+		std::unordered_map<uint64_t, std::unique_ptr<RegionFile>>				_regions;
+		std::mutex							_regionsMtx;
+
+		std::atomic<uint64_t>				_readCount = 0;
+		std::atomic<uint64_t>				_writeCount = 0;
+		std::atomic<uint64_t>				_writtenBytes = 0;
+
+		void								_routine();
+		void								_readBatch(std::vector<ReadRequest> &reads);
+		void								_writeBatch();
+		RegionFile							&_getRegion(const mlm::ivec2 &chunkPos);
+		// Returns nullptr if the region file of the chunk isn't open
+		RegionFile							*_findRegion(const mlm::ivec2 &chunkPos);
+
+		static uint64_t						_key(const mlm::ivec2 &pos);
+};
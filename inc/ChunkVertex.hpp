@@ -0,0 +1,65 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/*
+	Packed vertex used by chunk meshes, decoded in geometry.vert and shadow.vert.
+
+	position:	x (5 bits) | y (9 bits) | z (5 bits)
+	attributes:	face (3 bits) | block type (8 bits)
+
+	Positions are corners local to the chunk, so they go up to and including the chunk size.
+*/
+struct ChunkVertex {
+	uint32_t	position;
+	uint32_t	attributes;
+};
+
+// Vertices that don't change once built, so chunk meshes and the mesh cache can share them without copying
+using ChunkVerticesPtr = std::shared_ptr<const std::vector<ChunkVertex>>;
+
+constexpr uint32_t	CHUNK_VERTEX_X_BITS = 5;
+constexpr uint32_t	CHUNK_VERTEX_Y_BITS = 9;
+constexpr uint32_t	CHUNK_VERTEX_Z_BITS = 5;
+constexpr uint32_t	CHUNK_VERTEX_FACE_BITS = 3;
+constexpr uint32_t	CHUNK_VERTEX_TYPE_BITS = 8;
+
+constexpr ChunkVertex	packChunkVertex(uint32_t x, uint32_t y, uint32_t z, uint32_t face, uint32_t type)
+{
+	return (ChunkVertex{
+		x | (y << CHUNK_VERTEX_X_BITS) | (z << (CHUNK_VERTEX_X_BITS + CHUNK_VERTEX_Y_BITS)),
+		face | (type << CHUNK_VERTEX_FACE_BITS)
+	});
+}
+
+constexpr uint32_t	unpackChunkVertexX(const ChunkVertex &vertex)
+{
+	return (vertex.position & ((1u << CHUNK_VERTEX_X_BITS) - 1));
+}
+
+constexpr uint32_t	unpackChunkVertexY(const ChunkVertex &vertex)
+{
+	return ((vertex.position >> CHUNK_VERTEX_X_BITS) & ((1u << CHUNK_VERTEX_Y_BITS) - 1));
+}
+
+constexpr uint32_t	unpackChunkVertexZ(const ChunkVertex &vertex)
+{
+	return ((vertex.position >> (CHUNK_VERTEX_X_BITS + CHUNK_VERTEX_Y_BITS)) & ((1u << CHUNK_VERTEX_Z_BITS) - 1));
+}
+
+constexpr uint32_t	unpackChunkVertexFace(const ChunkVertex &vertex)
+{
+	return (vertex.attributes & ((1u << CHUNK_VERTEX_FACE_BITS) - 1));
+}
+
+constexpr uint32_t	unpackChunkVertexType(const ChunkVertex &vertex)
+{
+	return ((vertex.attributes >> CHUNK_VERTEX_FACE_BITS) & ((1u << CHUNK_VERTEX_TYPE_BITS) - 1));
+}
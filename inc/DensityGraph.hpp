@@ -0,0 +1,191 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Spline.hpp"
+#include "Perlin.hpp"
+
+// Most positions a density program evaluates at once
+constexpr size_t	DENSITY_BATCH_SIZE = 64;
+// Most column values the block part of a program can read
+constexpr size_t	DENSITY_COLUMN_TERMS = 8;
+// Most registers, 2D and 3D noises a program can use
+constexpr size_t	DENSITY_REGISTERS = 32;
+constexpr size_t	DENSITY_COLUMN_NOISES = 8;
+constexpr size_t	DENSITY_BLOCK_NOISES = 8;
+
+struct NoiseSettings {
+	Spline	spline;
+	float	depth = 1.0f;
+	float	step = 1.0f;
+	float	zoom = 100.0f;
+};
+
+/*
+// A node of the density graph. Inputs are names of other nodes, of the coordinates x, y and z,
+// or of the constants the graph is compiled with
+*/
+struct DensityNode {
+	enum Type {
+		CONSTANT,	// value
+		NOISE,		// noise settings called noise, seeded with the terrain seed + seed
+		SPLINE,		// spline(input 0)
+		ADD,
+		SUB,
+		MUL,
+		MIN,
+		MAX,
+		ABS,
+		FLOOR,
+		CLAMP,		// input 0 between min and max
+		THRESHOLD,	// 1 if input 0 is larger than input 1, 0 otherwise
+		SELECT,		// input 1 if input 0 is larger than 0, input 2 otherwise
+	};
+
+	Type						type = CONSTANT;
+	std::vector<std::string>	inputs;
+	float						value = 0.0f;
+	float						min = 0.0f;
+	float						max = 0.0f;
+	std::string					noise;
+	uint64_t					seed = 0;
+	int							dimensions = 2;
+	Spline						spline;
+};
+
+/*
+// Describes how the terrain is built from noise. height and sand can't depend on y, a column is sand
+// when sand is larger than 0. A solid block is carved out when every cave output is 0 or less
+*/
+struct DensityGraph {
+	std::map<std::string, DensityNode>	nodes;
+	std::string							height;
+	std::string							sand;
+	std::vector<std::string>			caves;
+};
+
+/*
+// A density graph compiled into flat instruction lists. The column part is evaluated once per column,
+// only the nodes that depend on y are in the block part. Nodes with constant inputs are folded, identical
+// nodes are evaluated once, and registers are reused as soon as the value in them isn't needed anymore.
+// The block part is split per cave output, blocks that can't be a cave anymore skip the outputs after it
+*/
+class DensityProgram {
+	public:
+		DensityProgram();
+		// noises and constants are the noise settings and values the graph can refer to by name
+		DensityProgram(const DensityGraph &graph, const std::map<std::string, NoiseSettings> &noises, const std::map<std::string, float> &constants);
+		~DensityProgram();
+
+		void					setSeed(uint64_t seed);
+		// Applies to the splines of all noises and spline nodes
+		void					setSplineResolution(uint64_t resolution);
+
+		// Height, sand and the DENSITY_COLUMN_TERMS terms of count columns. noises holds every column noise at the columns
+		// when they come from a lattice, or is nullptr to sample them. count can't be more than DENSITY_BATCH_SIZE
+		void					getColumns(const float *xs, const float *zs, const float *const *noises, float *heights, float *sand, float *terms, size_t count) const;
+		// Writes the indices of the heights in ys that are caves in the column at x and z to out, and returns how many there are.
+		// noises holds every block noise at the heights when they come from a lattice, or is nullptr to sample them.
+		// count can't be more than DENSITY_BATCH_SIZE
+		size_t					getCaves(const float *terms, float x, float z, const float *ys, const float *const *noises, size_t *out, size_t count) const;
+
+		// The 2D noises read by the column part and the 3D noises read by the block part, so they can be sampled on a lattice
+		size_t					getColumnNoiseCount() const;
+		void					getColumnNoise(size_t index, const float *xs, const float *zs, float *out, size_t count) const;
+		size_t					getBlockNoiseCount() const;
+		void					getBlockNoise(size_t index, const float *xs, const float *ys, const float *zs, float *out, size_t count) const;
+
+		size_t					getColumnInstructionCount() const;
+		size_t					getBlockInstructionCount() const;
+		size_t					getRegisterCount() const;
+
+	private:
+		enum Op {
+			X,
+			Y,
+			Z,
+			TERM,
+			NOISE,
+			SPLINE,
+			ADD,
+			SUB,
+			MUL,
+			MIN,
+			MAX,
+			ABS,
+			FLOOR,
+			CLAMP,
+			THRESHOLD,
+			SELECT,
+		};
+
+		// A register, or a folded constant
+		struct Operand {
+			bool		constant = true;
+			uint32_t	reg = 0;
+			float		value = 0.0f;
+		};
+
+		struct Instruction {
+			Op			op;
+			uint32_t	dst;
+			Operand		inputs[3];
+			// Noise, spline or column term
+			uint32_t	index = 0;
+			// Column or block noise the value comes from when the noises come from a lattice
+			uint32_t	slot = 0;
+			float		min = 0.0f;
+			float		max = 0.0f;
+		};
+
+		// Instructions of one cave output, and the registers still needed by the ones after it
+		struct Segment {
+			std::vector<Instruction>	code;
+			Operand						output;
+			std::vector<uint32_t>		live;
+		};
+
+		struct Noise {
+			Perlin			sampler;
+			NoiseSettings	settings;
+			uint64_t		seed;
+			int				dimensions;
+		};
+
+		// Positions and inputs of one evaluation
+		struct Context {
+			const float			*xs;
+			const float			*ys;
+			const float			*zs;
+			const float			*terms;
+			const float *const	*noises;
+			const size_t		*lanes;
+		};
+
+		using Registers = float[DENSITY_REGISTERS][DENSITY_BATCH_SIZE];
+
+		std::vector<Noise>			_noises;
+		std::vector<Spline>			_splines;
+		std::vector<uint32_t>		_columnNoises;
+		std::vector<uint32_t>		_blockNoises;
+		std::vector<Instruction>	_columnCode;
+		Operand						_height;
+		Operand						_sand;
+		std::vector<Operand>		_terms;
+		std::vector<Segment>		_segments;
+		size_t						_registerCount = 0;
+
+		void					_run(const Instruction &instruction, Registers &registers, const Context &context, size_t count) const;
+		static const float		*_load(const Operand &operand, Registers &registers, float *broadcast, size_t count);
+		template <typename Function>
+		static void				_apply(float *out, const Operand &a, const Operand &b, Registers &registers, size_t count, Function function);
+
+		friend class DensityCompiler;
+};
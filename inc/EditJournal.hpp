@@ -0,0 +1,86 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "glu/gl-utils.hpp"
+#include "Block.hpp"
+
+#include <atomic>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+struct ChunkSnapshot;
+
+/*
+// Keeps the blocks changed by the player, everything else is regenerated from the seed.
+// Every edit is appended to a journal as one checksummed record, so a crash loses at most the edit
+// being written. Records aren't synced, a power loss can lose the latest ones. Once the journal grows
+// too long it is compacted into a file of per chunk deltas on a thread of its own
+*/
+class EditJournal {
+	public:
+		EditJournal();
+		~EditJournal();
+
+		// Loads the deltas and replays the journals in path, a torn record at the end is cut off
+		void										start(const std::string &path);
+		// Waits for a running compaction, compacts the journal and closes it
+		void										stop();
+		bool										isRunning() const;
+
+		// Only does a write() on the calling thread, a full journal is handed to the compaction thread
+		void										record(const mlm::ivec2 &chunkPos, const mlm::ivec3 &blockChunkCoord, Block block);
+		// Sets the edited blocks of a chunk in snapshot, returns whether any were set
+		bool										apply(const mlm::ivec2 &chunkPos, ChunkSnapshot &snapshot) const;
+		// Writes all deltas to a new file, replaces the old one with it and empties the journal. Blocks until it is on disk
+		void										compact();
+
+		uint64_t									getEditCount() const;
+		uint64_t									getChunkCount() const;
+
+	private:
+		using ChunkKey = std::pair<int32_t, int32_t>;
+		// Index3D of the block to its type
+		using Deltas = std::map<uint16_t, Block::Type>;
+
+		static constexpr char						DELTAS_MAGIC[4] = {'V', 'O', 'X', 'D'};
+		static constexpr char						JOURNAL_MAGIC[4] = {'V', 'O', 'X', 'J'};
+		static constexpr uint32_t					VERSION = 1;
+		static constexpr size_t						HEADER_SIZE = sizeof(JOURNAL_MAGIC) + sizeof(VERSION);
+		// x, z, index, type and the checksum of those
+		static constexpr size_t						RECORD_SIZE = 4 + 4 + 2 + 1 + 4;
+		// Journal records before it gets compacted
+		static constexpr uint64_t					COMPACT_RECORDS = 4096;
+
+		std::string									_path;
+		std::map<ChunkKey, Deltas>					_deltas;
+		uint64_t									_editCount = 0;
+		// Guards the deltas and the journal, edits come from the main thread while workers apply them
+		mutable std::mutex							_mtx;
+		int											_journalFd = -1;
+		uint64_t									_journalRecords = 0;
+		std::atomic<bool>							_running = false;
+
+		// Only one compaction at a time, the compaction thread or compact and stop
+		std::mutex									_compactMtx;
+		std::thread									_thread;
+		std::condition_variable						_wake;
+		bool										_compactRequested = false;
+
+		void										_setDelta(const ChunkKey &key, uint16_t index, Block::Type type);
+		void										_loadDeltas();
+		size_t										_replayJournal(const std::string &path);
+		void										_openJournal();
+		bool										_rotateJournal();
+		void										_compact();
+		void										_routine();
+
+		static uint32_t								_checksum(const uint8_t *data, size_t size);
+};
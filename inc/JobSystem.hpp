@@ -0,0 +1,85 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*
+// Runs jobs on a fixed amount of worker threads. Every worker has its own deques, one per priority,
+// jobs are spread over them round robin and a worker that runs out of jobs steals from the others.
+// A worker takes the lowest priority it can find, its own jobs first when another worker has nothing lower.
+// Workers without work block on a condition variable instead of polling
+*/
+class JobSystem {
+	public:
+		using Job = std::function<void()>;
+		// Returns the new priority of a waiting job from its key, or CANCELLED to drop it
+		using Reprioritizer = std::function<size_t(uint64_t key)>;
+
+		// Lower priorities run first, higher ones are clamped to the last one
+		static constexpr size_t					PRIORITY_COUNT = 64;
+		static constexpr size_t					CANCELLED = PRIORITY_COUNT;
+
+		JobSystem();
+		~JobSystem();
+
+		void									start(int threadCount);
+		// Joins the workers, jobs that haven't started yet are dropped
+		void									stop();
+
+		void									submit(Job job, size_t priority = 0, uint64_t key = 0);
+		// Moves every job that hasn't started yet to the priority reprioritizer returns for its key.
+		// Locks one worker at a time, so workers keep running the jobs of the others
+		void									reprioritize(const Reprioritizer &reprioritizer);
+		uint64_t								getPendingCount() const;
+		int										getThreadCount() const;
+		// Jobs taken from another worker, and worker locks that were already held when they were taken
+		uint64_t								getStealCount() const;
+		uint64_t								getContendedCount() const;
+		uint64_t								getLockCount() const;
+
+	private:
+		struct QueuedJob {
+			Job			job;
+			uint64_t	key;
+		};
+
+		struct Worker {
+			std::array<std::deque<QueuedJob>, PRIORITY_COUNT>	jobs;
+			// Lowest priority with a job, PRIORITY_COUNT when empty. Written under mtx, read without it to pick a worker
+			std::atomic<size_t>									lowest = PRIORITY_COUNT;
+			std::mutex											mtx;
+		};
+
+		std::vector<std::unique_ptr<Worker>>	_workers;
+		std::vector<std::thread>				_threads;
+		std::atomic<uint64_t>					_nextWorker = 0;
+
+		// Jobs submitted and not yet taken. Incremented before a job is pushed, so it can briefly count a job a worker can't find yet
+		std::atomic<uint64_t>					_pending = 0;
+		// Workers waiting on _wake, submit only takes _sleepMtx to wake one when this isn't 0
+		std::atomic<int>						_sleeping = 0;
+		std::atomic<bool>						_running = false;
+		std::mutex								_sleepMtx;
+		std::condition_variable					_wake;
+
+		std::atomic<uint64_t>					_steals = 0;
+		std::atomic<uint64_t>					_contended = 0;
+		std::atomic<uint64_t>					_locks = 0;
+
+		void									_routine(size_t index);
+		bool									_popJob(size_t index, Job &job);
+		void									_lockWorker(Worker &worker);
+		static void								_updateLowest(Worker &worker);
+};
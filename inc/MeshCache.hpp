@@ -0,0 +1,118 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "glu/gl-utils.hpp"
+#include "ChunkVertex.hpp"
+
+#include <atomic>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+struct ChunkNeighborhood;
+
+/*
+// Meshes keyed by a hash of everything meshing reads: the blocks of the chunk, the border
+// slabs of its neighbors and the meshing mode. A chunk with the same hash gets the same mesh,
+// as long as a second hash of the same blocks matches too.
+// Least recently used meshes are dropped once the cache is over capacity, or spilled to disk.
+// Spilled meshes are kept across sessions, the least recently used files are deleted once they are over their own capacity
+*/
+class MeshCache {
+	public:
+		// The vertices are shared with the chunk meshes built from them
+		struct Entry {
+			ChunkVerticesPtr			vertices;
+			ChunkVerticesPtr			waterVertices;
+			mlm::vec3					min;
+			mlm::vec3					max;
+			// How long building the mesh took, saved again by every hit
+			uint64_t					microseconds;
+		};
+		using EntryPtr = std::shared_ptr<const Entry>;
+
+		// Entries are found by hash, check is compared to tell apart blocks whose hashes collide
+		struct Key {
+			uint64_t	hash;
+			uint64_t	check;
+		};
+
+		struct Stats {
+			uint64_t	hits;
+			uint64_t	spillHits;
+			uint64_t	misses;
+			// Lookups that found a mesh with the same hash but another check
+			uint64_t	collisions;
+			uint64_t	microsecondsSaved;
+		};
+
+		MeshCache();
+		~MeshCache();
+
+		// A capacity of 0 disables the cache, an empty spillPath disables spilling
+		void						init(size_t capacityBytes, const std::string &spillPath, size_t spillCapacityBytes);
+		bool						isEnabled() const;
+
+		static Key					hash(const ChunkNeighborhood &area, bool greedyMeshing);
+		// Returns nullptr if the mesh isn't cached
+		EntryPtr					find(const Key &key);
+		void						insert(const Key &key, EntryPtr entry);
+		void						clear();
+
+		Stats						getStats() const;
+		size_t						getBytes() const;
+		size_t						getSpillBytes() const;
+
+	private:
+		struct Slot {
+			uint64_t	key;
+			uint64_t	check;
+			EntryPtr	entry;
+		};
+		struct SpillFile {
+			uint64_t	key;
+			uint64_t	check;
+			size_t		size;
+		};
+		using Lru = std::list<Slot>;
+		using SpillLru = std::list<SpillFile>;
+
+		static constexpr char		MAGIC[4] = {'V', 'O', 'X', 'M'};
+		static constexpr uint32_t	VERSION = 2;
+
+		Lru							_lru;
+		std::unordered_map<uint64_t, Lru::iterator>	_index;
+		size_t						_bytes = 0;
+		size_t						_capacity = 0;
+		std::string					_spillPath;
+		// Files in _spillPath, most recently written or read first
+		SpillLru					_spillLru;
+		std::unordered_map<uint64_t, SpillLru::iterator>	_spillIndex;
+		size_t						_spillBytes = 0;
+		size_t						_spillCapacity = 0;
+		mutable std::mutex			_mtx;
+
+		std::atomic<uint64_t>		_hits = 0;
+		std::atomic<uint64_t>		_spillHits = 0;
+		std::atomic<uint64_t>		_misses = 0;
+		std::atomic<uint64_t>		_collisions = 0;
+		std::atomic<uint64_t>		_microsecondsSaved = 0;
+
+		void						_insert(Slot slot, std::vector<Slot> &evicted);
+		void						_spill(const Slot &slot);
+		void						_addSpill(const SpillFile &file);
+		void						_trimSpill(std::vector<uint64_t> &removed);
+		void						_loadSpillIndex();
+		std::string					_spillFile(uint64_t key) const;
+		EntryPtr					_readSpill(const Key &key);
+		size_t						_writeSpill(const Slot &slot) const;
+
+		static size_t				_entryBytes(const Entry &entry);
+};
@@ -7,22 +7,28 @@ Created on: 08/08/2025
 
 #include "glu/gl-utils.hpp"
 
-#include <unordered_map>
-
+/*
+// Gradients come from fixed tables that are shared by every sampler, the seeded hash of a lattice
+// corner only picks an entry. Samplers don't change while sampling, so one can be used by many threads
+*/
 class Perlin {
 	public:
+		Perlin();
+		Perlin(uint64_t seed);
+
 		void									setSeed(uint64_t seed);
-		float									getValue(float x, float y);
-		float									getValue(float x, float y, float z);
+		float									getValue(float x, float y) const;
+		float									getValue(float x, float y, float z) const;
+		// Same as getValue for count points at once, out[i] is the value at (xs[i], ys[i][, zs[i]])
+		void									getValues(const float *xs, const float *ys, float *out, size_t count) const;
+		void									getValues(const float *xs, const float *ys, const float *zs, float *out, size_t count) const;
 
 	private:
 		uint64_t								_seed = 1;
-		std::unordered_map<uint64_t, mlm::vec2>	_2dGradients;
-		std::unordered_map<uint64_t, mlm::vec3>	_3dGradients;
 
 		float									_smoothStep(float t) const;
-		mlm::vec2								_gradient(int x, int y);
-		mlm::vec3								_gradient(int x, int y, int z);
+		const mlm::vec2							&_gradient(int x, int y) const;
+		const mlm::vec3							&_gradient(int x, int y, int z) const;
 		uint64_t								_hash(int x, int y) const;
 		uint64_t								_hash(int x, int y, int z) const;
 };
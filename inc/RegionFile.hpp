@@ -0,0 +1,63 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#pragma once
+
+#include "glu/gl-utils.hpp"
+
+#include <array>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+constexpr int		REGION_SIZE = 32; // Chunks along each side of a region, MUST BE POWER OF 2
+constexpr uint64_t	REGION_CHUNKS = REGION_SIZE * REGION_SIZE;
+
+/*
+// A file with the saved chunks of a REGION_SIZE x REGION_SIZE tile of chunks. It starts with a header
+// holding the offset and size of every chunk record, records are appended behind it.
+// A record is only linked in the header after it is synced to disk, so a write that is cut off, by a crash or
+// a power loss, never leaves a half written chunk.
+// Rewritten chunks leave their old record behind, the file isn't compacted
+*/
+class RegionFile {
+	public:
+		// Called with the record of every chunk of a read that is in the file
+		using ReadCallback = std::function<void(const mlm::ivec2 &chunkPos, const uint8_t *data, size_t size)>;
+
+		// Reads the header if the file exists, the file is created by the first write
+		RegionFile(const std::string &path);
+		~RegionFile();
+
+		static mlm::ivec2	getRegionPos(const mlm::ivec2 &chunkPos);
+
+		bool				contains(const mlm::ivec2 &chunkPos) const;
+		// Forgets the record of a chunk, so it isn't read anymore
+		void				remove(const mlm::ivec2 &chunkPos);
+
+		// Opens the file once for all chunks, with mmapReads the file is mapped instead of read
+		void				read(const std::vector<mlm::ivec2> &chunkPositions, bool mmapReads, const ReadCallback &callback) const;
+		// Appends all records in one write, then links them in the header
+		void				write(const std::vector<std::pair<mlm::ivec2, std::vector<uint8_t>>> &records);
+
+	private:
+		struct Entry {
+			uint32_t	offset;
+			uint32_t	size;
+		};
+
+		static constexpr char		MAGIC[4] = {'V', 'O', 'X', 'R'};
+		static constexpr uint32_t	VERSION = 1;
+		static constexpr size_t		HEADER_SIZE = sizeof(MAGIC) + sizeof(VERSION) + REGION_CHUNKS * sizeof(Entry);
+
+		std::string							_path;
+		std::array<Entry, REGION_CHUNKS>	_entries = {};
+		uint64_t							_end = HEADER_SIZE;
+		// The I/O thread writes while the main thread checks which chunks are saved
+		mutable std::mutex					_entriesMtx;
+
+		static uint64_t						_index(const mlm::ivec2 &chunkPos);
+};
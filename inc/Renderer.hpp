@@ -33,6 +33,7 @@ class Renderer {
 		void			_initMeshes();
 		void			_initFrameBuffers();
 		void			_initSsaoSamples();
+		void			_initGeometryShader();
 		void			_initSsaoBlurShader();
 		void			_initSsaoNoise();
 
@@ -9,8 +9,14 @@ Created on: 24/08/2025
 
 #include <vector>
 
+/*
+// Catmull-Rom curve through a set of points. The curve is baked into a table of _resolution samples
+// between the first and last point, evaluate looks up and lerps between the 2 closest samples
+*/
 class Spline {
 	public:
+		static constexpr uint64_t	DEFAULT_RESOLUTION = 1024;
+
 		Spline();
 		Spline(const std::vector<mlm::vec2> &points);
 		Spline(const Spline &src);
@@ -18,12 +24,28 @@ class Spline {
 		Spline					&operator=(const Spline &src);
 
 		void					setPoints(const std::vector<mlm::vec2> &points);
+		// 0 doesn't bake a table, evaluate is exact then
+		void					setResolution(uint64_t resolution);
+		uint64_t				getResolution() const;
 
 		float					evaluate(float t) const;
+		// in and out can be the same array
+		void					evaluate(const float *in, float *out, size_t count) const;
+		float					evaluateExact(float t) const;
 
 		bool					isReady();
+
+		// Values the calling thread evaluated in batches, lets the benchmark see how much of generation goes to splines
+		static uint64_t			getBatchEvaluations();
 	private:
+		static thread_local uint64_t	_batchEvaluations;
+
 		std::vector<mlm::vec2>	_points;
+		uint64_t				_resolution = DEFAULT_RESOLUTION;
+		std::vector<float>		_table;
+		float					_tableScale = 0.0f;
+
+		void					_bake();
 
 		float					_catmullRom(const float y0, const float y1, const float y2, const float y3, const float t) const;
 };
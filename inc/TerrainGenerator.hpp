@@ -5,11 +5,14 @@ Created on: 13/10/2025
 
 #pragma once
 
+#include <array>
 #include <memory>
+#include <vector>
 
 #include "Spline.hpp"
 #include "Block.hpp"
 #include "Perlin.hpp"
+#include "DensityGraph.hpp"
 
 struct perlinSamplers {
 	Perlin	height;
@@ -18,11 +21,26 @@ struct perlinSamplers {
 	Perlin	sand;
 };
 
-struct NoiseSettings {
-	Spline	spline;
-	float	depth = 1.0f;
-	float	step = 1.0f;
-	float	zoom = 100.0f;
+// Everything about a column of terrain that doesn't depend on y
+struct TerrainColumn {
+	int										height;
+	bool									sand;
+	// Column values the caves of the density graph read
+	std::array<float, DENSITY_COLUMN_TERMS>	terms;
+};
+
+/*
+// The 3D noises the caves read of an area, sampled every step blocks on a lattice aligned to world coordinates.
+// Blocks in between are interpolated. With step 0 there is no lattice, and the noise is sampled for every block
+*/
+struct CaveLattice {
+	int								step = 0;
+	mlm::ivec3						origin;
+	mlm::ivec3						size;
+	std::vector<std::vector<float>>	noises;
+
+	// Every noise for count blocks up from y in the column at x and z, values[i] gets noise i
+	void							getColumn(int x, int z, int y, float *const *values, size_t count) const;
 };
 
 struct TerrainGeneratorDTO {
@@ -34,6 +52,12 @@ struct TerrainGeneratorDTO {
 	float			sandBeachThreshold;
 	float			sandSeaThreshold;
 	NoiseSettings	sand;
+	// Blocks between lattice points for the 2D noise of the columns and the 3D noise of the caves, 0 samples every block
+	float			latticeStep = 0.0f;
+	// Table size the noise splines are baked into, 0 evaluates them exactly
+	float			splineResolution = static_cast<float>(Spline::DEFAULT_RESOLUTION);
+	// How the noises above make up the terrain, the batch functions evaluate it
+	DensityGraph	densityGraph;
 };
 
 class TerrainGenerator {
@@ -42,27 +66,48 @@ class TerrainGenerator {
 		TerrainGenerator(const TerrainGeneratorDTO &dto);
 		~TerrainGenerator();
 
-		int				getTerrainHeight(perlinSamplers &samplers, const mlm::ivec2 &pos);
-		int				getTerrainHeight(perlinSamplers &samplers, const mlm::ivec3 &pos);
-
-
-		Block			getBlock(perlinSamplers &samplers, const mlm::ivec3 &pos, int terrainHeight);
-		bool			isCave(perlinSamplers &samplers, const mlm::ivec3 &pos);
-		bool			isSand(perlinSamplers &samplers, const mlm::ivec2 &pos, int terrainHeight);
-
-		perlinSamplers	getSamplers();
+		// These evaluate the density graph for a single position, they always sample every block
+		int				getTerrainHeight(const mlm::ivec2 &pos) const;
+		int				getTerrainHeight(const mlm::ivec3 &pos) const;
+		Block			getBlock(const mlm::ivec3 &pos) const;
+		bool			isCave(const mlm::ivec3 &pos) const;
+		bool			isSand(const mlm::ivec2 &pos) const;
+
+		// Batch version, it gives the same results as calling the single version for every position
+		// Heights of count columns along x, starting at pos
+		void			getTerrainHeights(const mlm::ivec2 &pos, int *out, size_t count) const;
+		// These evaluate the density graph and follow latticeStep. With latticeStep 0 they give the same blocks
+		// as the single versions
+		// Columns of a size.x by size.y area starting at pos, x changes fastest
+		void			getColumns(const mlm::ivec2 &pos, const mlm::ivec2 &size, TerrainColumn *out) const;
+		// Cave noise of the area getBlocks will be called for
+		CaveLattice		getCaveLattice(const mlm::ivec3 &pos, const mlm::ivec3 &size) const;
+		// Blocks of count positions up along y from pos, pos has to be in column and in caves
+		void			getBlocks(const TerrainColumn &column, const CaveLattice &caves, const mlm::ivec3 &pos, Block *out, size_t count) const;
+
+		// Shared by every chunk that generates with this generator, sampling doesn't change them
+		const perlinSamplers	&getSamplers() const;
+		const DensityProgram	&getDensityProgram() const;
 
 		void			setSeed(uint64_t seed);
 		uint64_t		getSeed() const;
 
+		// Applies to the splines of all noises
+		void			setSplineResolution(uint64_t resolution);
+
+		void			setLatticeStep(int latticeStep);
+		int				getLatticeStep() const;
+
 		void			setSeaLevel(int seaLevel);
 		int				getSeaLevel() const;
 
 		void			setContinentalnessSpline(const Spline &spline);
 		const Spline	&getContinentalnessSpline() const;
 
-		static float	noise2D(Perlin &sampler, const NoiseSettings &settings, const mlm::vec2 &pos);
-		static float	noise3D(Perlin &sampler, const NoiseSettings &settings, const mlm::vec3 &pos);
+		static float	noise2D(const Perlin &sampler, const NoiseSettings &settings, const mlm::vec2 &pos);
+		static float	noise3D(const Perlin &sampler, const NoiseSettings &settings, const mlm::vec3 &pos);
+		static void		noise2D(const Perlin &sampler, const NoiseSettings &settings, const float *xs, const float *ys, float *out, size_t count);
+		static void		noise3D(const Perlin &sampler, const NoiseSettings &settings, const float *xs, const float *ys, const float *zs, float *out, size_t count);
 
 	private:
 		uint64_t		_seed;
@@ -73,9 +118,24 @@ class TerrainGenerator {
 		float			_sandSeaThreshold;
 		NoiseSettings	_sand;
 		NoiseSettings	_continentalness;
-
-		static float	_octaves2D(Perlin &sampler, const mlm::vec2 &pos, uint64_t depth, float step);
-		static float	_octaves3D(Perlin &sampler, const mlm::vec3 &pos, uint64_t depth, float step);
+		int				_latticeStep;
+		uint64_t		_splineResolution;
+		perlinSamplers	_samplers;
+		DensityGraph	_graph;
+		DensityProgram	_program;
+
+		static float	_octaves2D(const Perlin &sampler, const mlm::vec2 &pos, uint64_t depth, float step);
+		static float	_octaves3D(const Perlin &sampler, const mlm::vec3 &pos, uint64_t depth, float step);
+		static void		_octaves(const Perlin &sampler, const float *xs, const float *ys, const float *zs, float *out, size_t count, uint64_t depth, float step);
+
+		// Compiles the density graph with the current settings
+		void			_compile();
+		// count columns at xs and zs, count can't be more than DENSITY_BATCH_SIZE. noises is passed on to the program
+		void			_evaluateColumns(const float *xs, const float *zs, const float *const *noises, TerrainColumn *out, size_t count) const;
+		// The column at pos, sampled without a lattice
+		TerrainColumn	_getColumn(const mlm::ivec2 &pos) const;
+		Block::Type		_getTerrainType(int y, int terrainHeight, bool sand) const;
+		bool			_isUnderwater(int y, int terrainHeight) const;
 };
 
 using TerrainGeneratorPtr = std::shared_ptr<TerrainGenerator>;
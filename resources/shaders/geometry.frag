@@ -5,14 +5,47 @@ layout (location = 1) out vec4	gNormal;
 layout (location = 2) out vec4	gPosition;
 
 uniform sampler2D	uAtlas;
+uniform float		uTilePixelWidth;
 
-in vec3	vertViewWorldPos;
-in vec3	vertViewNormal;
-in vec2	vertTexUV;
+in vec3			vertViewWorldPos;
+in vec3			vertViewNormal;
+in vec3			vertLocalPos;
+flat in int		vertFace;
+flat in int		vertTile;
+
+// Position on the face in blocks, oriented the same way as the atlas tiles
+vec2	faceCoord(vec3 pos, int face)
+{
+	switch (face)
+	{
+		case 0: // top
+			return (vec2(pos.x, -pos.z));
+		case 1: // back
+			return (vec2(-pos.x, pos.y));
+		case 2: // front
+			return (vec2(pos.x, pos.y));
+		case 3: // left
+			return (vec2(pos.z, pos.y));
+		case 4: // right
+			return (vec2(-pos.z, pos.y));
+		default: // bottom
+			return (vec2(pos.x, pos.z));
+	}
+}
 
 void	main()
 {
 	gNormal = vec4(normalize(vertViewNormal), 1.0);
 	gPosition = vec4(vertViewWorldPos, 1.0);
-	gColor = vec4(texture(uAtlas, vertTexUV).rgb, 1.0);
+
+	// Find the tile in the atlas
+	ivec2	atlasSize = textureSize(uAtlas, 0);
+	vec2	tileSize = uTilePixelWidth / vec2(atlasSize);
+	int		tilesPerRow = atlasSize.x / int(uTilePixelWidth);
+	vec2	tileOffset = vec2(vertTile % tilesPerRow, vertTile / tilesPerRow) * tileSize;
+
+	// Repeat the tile once per block, using the unwrapped coordinate for the gradients to avoid seams
+	vec2	coord = faceCoord(vertLocalPos, vertFace);
+	vec2	uv = tileOffset + fract(coord) * tileSize;
+	gColor = vec4(textureGrad(uAtlas, uv, dFdx(coord) * tileSize, dFdy(coord) * tileSize).rgb, 1.0);
 }
@@ -1,26 +1,49 @@
 #version 430 core
 
-layout (location = 0) in vec3	inPos;
-layout (location = 1) in vec3	inNormal;
-layout (location = 2) in vec2	inTexUV;
+// Packed chunk vertex, see ChunkVertex.hpp
+layout (location = 0) in uint	inPosition;
+layout (location = 1) in uint	inAttributes;
 
 uniform mat4 uProjection;
 uniform mat4 uModel;
 uniform mat4 uView;
 
-out vec3	vertViewWorldPos;
-out vec3	vertViewNormal;
-out vec2	vertTexUV;
+// Atlas tile of every face of every block type (Block::TYPE_COUNT * 6),
+// SHADER_TILE_TYPES in RendererInit.cpp has to match the block type count used here
+uniform int	uTiles[6 * 6];
+
+const vec3	normals[6] = vec3[](
+	vec3(0.0, 1.0, 0.0),
+	vec3(0.0, 0.0, -1.0),
+	vec3(0.0, 0.0, 1.0),
+	vec3(-1.0, 0.0, 0.0),
+	vec3(1.0, 0.0, 0.0),
+	vec3(0.0, -1.0, 0.0)
+);
+
+out vec3		vertViewWorldPos;
+out vec3		vertViewNormal;
+out vec3		vertLocalPos;
+flat out int	vertFace;
+flat out int	vertTile;
 
 void	main()
 {
+	// Unpack the vertex
+	vec3	pos = vec3(inPosition & 31u, (inPosition >> 5u) & 511u, (inPosition >> 14u) & 31u);
+	int		face = int(inAttributes & 7u);
+	int		type = int((inAttributes >> 3u) & 255u);
+
 	// Calculate the view position and NDC* position
-	vec4	tempPos = uView * uModel * vec4(inPos, 1.0);
+	vec4	tempPos = uView * uModel * vec4(pos, 1.0);
 	vertViewWorldPos = tempPos.xyz;
 	gl_Position = uProjection * tempPos;
 
 	// Calculate the normal based off of the view and model matrix
-	vertViewNormal = transpose(inverse(mat3(uView * uModel))) * normalize(inNormal);
+	vertViewNormal = transpose(inverse(mat3(uView * uModel))) * normals[face];
 
-	vertTexUV = inTexUV;
+	// Chunk local position and face are used to tile the texture across merged faces
+	vertLocalPos = pos;
+	vertFace = face;
+	vertTile = uTiles[type * 6 + face];
 }
@@ -1,8 +1,8 @@
 #version 430 core
 
-layout (location = 0) in vec3	inPos;
-layout (location = 1) in vec3	inNormal;
-layout (location = 2) in vec2	inTexUV;
+// Packed chunk vertex, see ChunkVertex.hpp
+layout (location = 0) in uint	inPosition;
+layout (location = 1) in uint	inAttributes;
 
 uniform mat4	uLightProjection;
 uniform mat4	uModel;
@@ -10,5 +10,6 @@ uniform mat4	uLightView;
 
 void	main()
 {
-	gl_Position = uLightProjection * uLightView * uModel * vec4(inPos, 1.0);
+	vec3	pos = vec3(inPosition & 31u, (inPosition >> 5u) & 511u, (inPosition >> 14u) & 31u);
+	gl_Position = uLightProjection * uLightView * uModel * vec4(pos, 1.0);
 }
@@ -23,29 +23,19 @@ bool	Atlas::load()
 	if (!bmp.data)
 		return (false);
 
-	// Define the size of each texture in the atlas in texture coordinates
-	mlm::vec2	offsetFormat(0.0f);
-	offsetFormat.x = atlasDto.pixelWidth / static_cast<float>(bmp.width);
-	offsetFormat.y = atlasDto.pixelWidth / static_cast<float>(bmp.height);
-
-	// Sets correct texture offsets for each block direction
+	// Sets the tile index of each block direction, counting from the bottom left of the atlas
+	int	tilesPerRow = bmp.width / static_cast<int>(atlasDto.pixelWidth);
 	for (auto &[type, textureOffsetNames] : atlasDto.blockOffsets)
 	{
-		std::vector<mlm::vec2>	temp;
-
-		// Transform offsets into texture coordinates
-		for (const std::string &textureOffsetName : textureOffsetNames)
-			temp.push_back(atlasDto.textureOffsets.at(textureOffsetName) * offsetFormat);
-
-		_offsets.insert({type, temp});
+		for (std::size_t side = 0; side < textureOffsetNames.size(); ++side)
+		{
+			const mlm::vec2	&offset = atlasDto.textureOffsets.at(textureOffsetNames[side]);
+			_tiles[type][side] = static_cast<int>(offset.y) * tilesPerRow + static_cast<int>(offset.x);
+		}
 	}
 
-	_uvCorners = {
-		mlm::vec2(0.0f, 0.0f) * (offsetFormat - std::numeric_limits<float>::epsilon()), // bottom left
-		mlm::vec2(1.0f, 0.0f) * (offsetFormat - std::numeric_limits<float>::epsilon()), // bottom right
-		mlm::vec2(0.0f, 1.0f) * (offsetFormat - std::numeric_limits<float>::epsilon()), // top left
-		mlm::vec2(1.0f, 1.0f) * (offsetFormat - std::numeric_limits<float>::epsilon()), // top right
-	};
+	// The shader finds the tile in the atlas from its index, so only the size of a tile is needed
+	_tilePixelWidth = atlasDto.pixelWidth;
 
 	_texture.load(bmp);
 	free_bmp(bmp);
@@ -57,14 +47,14 @@ void	Atlas::bind()
 	_texture.bind();
 }
 
-const std::vector<mlm::vec2>	&Atlas::getOffset(Block::Type blockType)
+int	Atlas::getTile(Block::Type blockType, int side) const
 {
-	return (_offsets[blockType]);
+	return (_tiles[blockType][side]);
 }
 
-const std::vector<mlm::vec2>	&Atlas::getCorners()
+float	Atlas::getTilePixelWidth() const
 {
-	return (_uvCorners);
+	return (_tilePixelWidth);
 }
 
 void	Atlas::del()
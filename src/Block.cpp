@@ -5,41 +5,40 @@ Created on: 06/08/2025
 
 #include "Block.hpp"
 
+static_assert(sizeof(Block) == 1, "Block should only hold its type");
+
+const Block::Properties	Block::_properties[Block::TYPE_COUNT] = {
+	{false, true},	// AIR
+	{true, false},	// DIRT
+	{true, false},	// GRASS
+	{true, false},	// STONE
+	{true, true},	// WATER
+	{true, false},	// SAND
+};
 
 Block::Block(): _type(AIR)
 {}
 
 Block::Block(Type type): _type(type)
-{
-	if (_type != AIR)
-		_isEnabled = true;
-}
+{}
 
-Block::Block(const Block &src): _type(src._type), _isEnabled(src._isEnabled)
+Block::Block(const Block &src): _type(src._type)
 {}
 
 Block	&Block::operator=(const Block &src)
 {
 	_type = src._type;
-	this->_isEnabled = src._isEnabled;
 	return (*this);
 }
 
 bool	Block::getEnabled() const
 {
-	return (_isEnabled);
-}
-
-void	Block::setEnabled(bool enabled)
-{
-	_isEnabled = enabled;
+	return (_properties[_type].enabled);
 }
 
 bool	Block::getTransparent() const
 {
-	return (_type == WATER || _type == AIR);
-	// 	return (true);
-	// return (false);
+	return (_properties[_type].transparent);
 }
 
 Block::Type	Block::getType() const
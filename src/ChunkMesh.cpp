@@ -4,6 +4,37 @@ Created on: 19/08/2025
 */
 
 #include "ChunkMesh.hpp"
+#include "Chunk.hpp"
+
+#include <algorithm>
+
+// Every face of every block type has to survive packing, at both ends of the chunk
+static constexpr bool	chunkVertexRoundTrip()
+{
+	for (uint32_t type = 0; type < Block::TYPE_COUNT; ++type)
+	{
+		for (uint32_t face = 0; face < 6; ++face)
+		{
+			for (uint32_t corner = 0; corner < 8; ++corner)
+			{
+				uint32_t	x = (corner & 1) ? CHUNK_SIZE_X : 0;
+				uint32_t	y = (corner & 2) ? CHUNK_SIZE_Y : 0;
+				uint32_t	z = (corner & 4) ? CHUNK_SIZE_Z : 0;
+				ChunkVertex	vertex = packChunkVertex(x, y, z, face, type);
+				if (unpackChunkVertexX(vertex) != x || unpackChunkVertexY(vertex) != y || unpackChunkVertexZ(vertex) != z
+					|| unpackChunkVertexFace(vertex) != face || unpackChunkVertexType(vertex) != type)
+					return (false);
+			}
+		}
+	}
+	return (true);
+}
+
+static_assert(chunkVertexRoundTrip(), "ChunkVertex can't hold every face of every block type");
+static_assert(sizeof(ChunkVertex) == 8, "ChunkVertex should be 8 bytes");
+
+GLuint	ChunkMesh::_quadIbo = 0;
+size_t	ChunkMesh::_quadCapacity = 0;
 
 ChunkMesh::ChunkMesh()
 {}
@@ -11,7 +42,7 @@ ChunkMesh::ChunkMesh()
 ChunkMesh::~ChunkMesh()
 {}
 
-ChunkMesh::ChunkMesh(const std::vector<Vertex> &vertices): _vertices(vertices)
+ChunkMesh::ChunkMesh(const std::vector<ChunkVertex> &vertices): _vertices(std::make_shared<std::vector<ChunkVertex>>(vertices))
 {
 	setup_mesh();
 }
@@ -20,32 +51,146 @@ void	ChunkMesh::draw(Shader &shader)
 {
 	(void)shader;
 	_vao.bind();
-	glDrawArrays(GL_TRIANGLES, 0, _vertices.size());
+	glDrawElements(GL_TRIANGLES, _indexCount, GL_UNSIGNED_INT, nullptr);
 	_vao.unbind();
 }
 
 void	ChunkMesh::setup_mesh()
 {
+	const std::vector<ChunkVertex>	&vertices = get_vertices();
+	size_t	quadCount = vertices.size() / 4;
+	_indexCount = static_cast<GLsizei>(quadCount * 6);
+
 	_vao.init();
 	_vao.bind();
 
+	// The element buffer binding is part of the VAO state, so it has to be bound while the VAO is
+	_reserveQuadIndices(quadCount);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadIbo);
+
 	// Setup Vertex buffer
-	_vbo = VBO(reinterpret_cast<GLfloat *>(_vertices.data()), static_cast<GLsizeiptr>(_vertices.size() * sizeof(Vertex)));
-	_vao.link_attr(_vbo, 0, sizeof(Vertex::pos) / sizeof(GLfloat), GL_FLOAT, sizeof(Vertex), (void *)offsetof(Vertex, pos));
-	_vao.link_attr(_vbo, 1, sizeof(Vertex::normal) / sizeof(GLfloat), GL_FLOAT, sizeof(Vertex), (void *)offsetof(Vertex, normal));
-	_vao.link_attr(_vbo, 2, sizeof(Vertex::texUV) / sizeof(GLfloat), GL_FLOAT, sizeof(Vertex), (void *)offsetof(Vertex, texUV));
+	// The VBO only reads the vertices
+	_vbo = VBO(reinterpret_cast<GLfloat *>(const_cast<ChunkVertex *>(vertices.data())), static_cast<GLsizeiptr>(vertices.size() * sizeof(ChunkVertex)));
+	_vbo.bind();
+	// The packed attributes are integers, which VAO::link_attr would convert to floats
+	glVertexAttribIPointer(0, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void *)offsetof(ChunkVertex, position));
+	glEnableVertexAttribArray(0);
+	glVertexAttribIPointer(1, 1, GL_UNSIGNED_INT, sizeof(ChunkVertex), (void *)offsetof(ChunkVertex, attributes));
+	glEnableVertexAttribArray(1);
 
 	_vao.unbind();
 	_vbo.unbind();
 }
 
-std::vector<Vertex>	&ChunkMesh::get_vertices()
+// Grows the shared index buffer in place, so VAOs that already reference it stay valid
+void	ChunkMesh::_reserveQuadIndices(size_t quadCount)
+{
+	if (quadCount <= _quadCapacity && _quadIbo != 0)
+		return ;
+	size_t	capacity = std::max<size_t>(_quadCapacity * 2, 1024);
+	while (capacity < quadCount)
+		capacity *= 2;
+
+	std::vector<GLuint>	indices(capacity * 6);
+	for (size_t quad = 0; quad < capacity; ++quad)
+	{
+		GLuint	base = static_cast<GLuint>(quad * 4);
+		indices[quad * 6 + 0] = base + 0;
+		indices[quad * 6 + 1] = base + 1;
+		indices[quad * 6 + 2] = base + 2;
+		indices[quad * 6 + 3] = base + 0;
+		indices[quad * 6 + 4] = base + 2;
+		indices[quad * 6 + 5] = base + 3;
+	}
+
+	if (_quadIbo == 0)
+		glGenBuffers(1, &_quadIbo);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, _quadIbo);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, static_cast<GLsizeiptr>(indices.size() * sizeof(GLuint)), indices.data(), GL_STATIC_DRAW);
+	_quadCapacity = capacity;
+}
+
+// The buffer if it was never shared, so it can be changed in place, nullptr otherwise.
+// Buffers the mesh makes itself are non-const vectors, const only keeps the ones it shares from changing
+std::vector<ChunkVertex>	*ChunkMesh::_ownedVertices()
+{
+	if (!_vertices || _verticesShared)
+		return (nullptr);
+	return (const_cast<std::vector<ChunkVertex> *>(_vertices.get()));
+}
+
+void	ChunkMesh::delQuadIndices()
+{
+	if (_quadIbo != 0)
+		glDeleteBuffers(1, &_quadIbo);
+	_quadIbo = 0;
+	_quadCapacity = 0;
+}
+
+const std::vector<ChunkVertex>	&ChunkMesh::get_vertices() const
+{
+	static const std::vector<ChunkVertex>	empty;
+	if (!_vertices)
+		return (empty);
+	return (*_vertices);
+}
+
+ChunkVerticesPtr	ChunkMesh::share_vertices()
 {
+	_verticesShared = true;
 	return (_vertices);
 }
 
+void	ChunkMesh::set_vertices(ChunkVerticesPtr vertices)
+{
+	_vertices = std::move(vertices);
+	_verticesShared = true;
+	_verticesFreed = false;
+}
+
+void	ChunkMesh::swap_vertices(std::vector<ChunkVertex> &vertices)
+{
+	std::vector<ChunkVertex>	*owned = _ownedVertices();
+	if (owned)
+		owned->swap(vertices);
+	else
+	{
+		_vertices = std::make_shared<std::vector<ChunkVertex>>(std::move(vertices));
+		_verticesShared = false;
+		vertices = std::vector<ChunkVertex>();
+	}
+	_verticesFreed = false;
+}
+
+void	ChunkMesh::clear_vertices()
+{
+	std::vector<ChunkVertex>	*owned = _ownedVertices();
+	if (owned)
+		owned->clear();
+	else
+		_vertices = nullptr;
+}
+
+void	ChunkMesh::free_vertices()
+{
+	_vertices = nullptr;
+	_verticesFreed = true;
+}
+
+bool	ChunkMesh::has_vertices() const
+{
+	return (_verticesFreed == false);
+}
+
+size_t	ChunkMesh::get_gpu_bytes() const
+{
+	// Every quad is 4 vertices and 6 indices
+	return (static_cast<size_t>(_indexCount) / 6 * 4 * sizeof(ChunkVertex));
+}
+
 void	ChunkMesh::del()
 {
 	_vao.del();
 	_vbo.del();
+	_indexCount = 0;
 }
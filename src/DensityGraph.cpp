@@ -0,0 +1,737 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "DensityGraph.hpp"
+#include "TerrainGenerator.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+#include <set>
+#include <stdexcept>
+#include <tuple>
+
+/*
+// Turns a density graph into a DensityProgram. Every node is resolved to a value first, values with only
+// constant inputs are folded and values with the same operation and inputs are merged.
+// The values are then split in a column and a block part, and given registers in the order they are evaluated
+*/
+class DensityCompiler {
+	public:
+		DensityCompiler(const DensityGraph &graph, const std::map<std::string, NoiseSettings> &noises, const std::map<std::string, float> &constants, DensityProgram &program);
+
+		void	compile();
+
+	private:
+		using Op = DensityProgram::Op;
+
+		struct Value {
+			Op					op = DensityProgram::X;
+			std::vector<int>	inputs;
+			bool				constant = false;
+			float				value = 0.0f;
+			float				min = 0.0f;
+			float				max = 0.0f;
+			uint32_t			index = 0;
+			bool				perBlock = false;
+		};
+
+		// A value in the evaluation order of a part, term items load a column value into a block register
+		struct Item {
+			int			value;
+			bool		term;
+			size_t		lastUse;
+			uint32_t	reg = 0;
+		};
+
+		using Key = std::tuple<bool, int, std::vector<int>, uint32_t, uint32_t, uint32_t, uint32_t>;
+
+		const DensityGraph							&_graph;
+		const std::map<std::string, NoiseSettings>	&_noiseSettings;
+		const std::map<std::string, float>			&_constants;
+		DensityProgram								&_program;
+
+		std::vector<Value>							_values;
+		std::map<std::string, int>					_resolved;
+		std::set<std::string>						_visiting;
+		std::map<Key, int>							_merged;
+		std::map<std::tuple<std::string, uint64_t, int>, uint32_t>	_noiseIndices;
+		// Column values the block part reads, in the order of their terms
+		std::vector<int>							_terms;
+
+		static Op	_op(DensityNode::Type type);
+		int		_resolve(const std::string &name);
+		int		_add(Value value);
+		float	_fold(const Value &value) const;
+		void	_collect(int id, bool perBlock, std::set<int> &out) const;
+
+		void	_compileColumns();
+		void	_compileBlocks();
+		void	_allocate(std::vector<Item> &items) const;
+		DensityProgram::Operand		_operand(int id, const std::vector<Item> &items, const std::map<int, size_t> &itemOf) const;
+		DensityProgram::Instruction	_instruction(const Item &item, const std::vector<Item> &items, const std::map<int, size_t> &valueItems, const std::map<int, size_t> &termItems) const;
+};
+
+// Inputs every node type needs, constants and noises have none
+static size_t	inputCount(DensityNode::Type type)
+{
+	switch (type)
+	{
+		case DensityNode::CONSTANT:
+		case DensityNode::NOISE:
+			return (0);
+		case DensityNode::SPLINE:
+		case DensityNode::ABS:
+		case DensityNode::FLOOR:
+		case DensityNode::CLAMP:
+			return (1);
+		case DensityNode::SELECT:
+			return (3);
+		default:
+			return (2);
+	}
+}
+
+DensityCompiler::DensityCompiler(const DensityGraph &graph, const std::map<std::string, NoiseSettings> &noises, const std::map<std::string, float> &constants, DensityProgram &program):
+	_graph(graph),
+	_noiseSettings(noises),
+	_constants(constants),
+	_program(program)
+{
+}
+
+void	DensityCompiler::compile()
+{
+	for (const auto &[name, node] : _graph.nodes)
+		if (name == "x" || name == "y" || name == "z" || _constants.count(name))
+			throw std::runtime_error("densityGraph: node name `" + name + "` is already used by a builtin");
+
+	int	height = _resolve(_graph.height);
+	int	sand = _resolve(_graph.sand);
+	if (_values[height].perBlock || _values[sand].perBlock)
+		throw std::runtime_error("densityGraph: the height and sand outputs can't depend on y");
+	for (const std::string &cave : _graph.caves)
+		_resolve(cave);
+
+	// Column values the block part reads
+	std::set<int>	blockValues;
+	std::set<int>	terms;
+	for (const std::string &cave : _graph.caves)
+		_collect(_resolved.at(cave), true, blockValues);
+	for (const std::string &cave : _graph.caves)
+		if (!_values[_resolved.at(cave)].perBlock && !_values[_resolved.at(cave)].constant)
+			terms.insert(_resolved.at(cave));
+	for (int id : blockValues)
+		for (int input : _values[id].inputs)
+			if (!_values[input].perBlock && !_values[input].constant)
+				terms.insert(input);
+	if (terms.size() > DENSITY_COLUMN_TERMS)
+		throw std::runtime_error("densityGraph: the cave outputs can't read more than " + std::to_string(DENSITY_COLUMN_TERMS) + " column values");
+
+	_terms.assign(terms.begin(), terms.end());
+	_compileColumns();
+	_compileBlocks();
+}
+
+DensityProgram::Op	DensityCompiler::_op(DensityNode::Type type)
+{
+	switch (type)
+	{
+		case DensityNode::ADD:
+			return (DensityProgram::ADD);
+		case DensityNode::SUB:
+			return (DensityProgram::SUB);
+		case DensityNode::MUL:
+			return (DensityProgram::MUL);
+		case DensityNode::MIN:
+			return (DensityProgram::MIN);
+		case DensityNode::MAX:
+			return (DensityProgram::MAX);
+		case DensityNode::ABS:
+			return (DensityProgram::ABS);
+		case DensityNode::FLOOR:
+			return (DensityProgram::FLOOR);
+		case DensityNode::THRESHOLD:
+			return (DensityProgram::THRESHOLD);
+		case DensityNode::SELECT:
+			return (DensityProgram::SELECT);
+		default:
+			throw std::runtime_error("densityGraph: node type has no operation");
+	}
+}
+
+int	DensityCompiler::_resolve(const std::string &name)
+{
+	auto	resolved = _resolved.find(name);
+	if (resolved != _resolved.end())
+		return (resolved->second);
+
+	Value	value;
+	auto	constant = _constants.find(name);
+	auto	node = _graph.nodes.find(name);
+	if (name == "x" || name == "y" || name == "z")
+	{
+		value.op = (name == "x") ? DensityProgram::X : (name == "y") ? DensityProgram::Y : DensityProgram::Z;
+		value.perBlock = (name == "y");
+	}
+	else if (constant != _constants.end())
+	{
+		value.constant = true;
+		value.value = constant->second;
+	}
+	else if (node != _graph.nodes.end())
+	{
+		const DensityNode	&src = node->second;
+		if (src.inputs.size() != inputCount(src.type))
+			throw std::runtime_error("densityGraph: node `" + name + "` needs " + std::to_string(inputCount(src.type)) + " inputs");
+		if (!_visiting.insert(name).second)
+			throw std::runtime_error("densityGraph: node `" + name + "` depends on itself");
+		for (const std::string &input : src.inputs)
+			value.inputs.push_back(_resolve(input));
+		_visiting.erase(name);
+
+		value.min = src.min;
+		value.max = src.max;
+		switch (src.type)
+		{
+			case DensityNode::CONSTANT:
+				value.constant = true;
+				value.value = src.value;
+				break ;
+			case DensityNode::NOISE:
+			{
+				auto	settings = _noiseSettings.find(src.noise);
+				if (settings == _noiseSettings.end())
+					throw std::runtime_error("densityGraph: node `" + name + "` uses unknown noise `" + src.noise + "`");
+				if (src.dimensions != 2 && src.dimensions != 3)
+					throw std::runtime_error("densityGraph: node `" + name + "` has to be 2 or 3 dimensional");
+				// Noises with the same settings and seed share a sampler
+				auto	[it, added] = _noiseIndices.try_emplace({src.noise, src.seed, src.dimensions}, static_cast<uint32_t>(_program._noises.size()));
+				if (added)
+					_program._noises.push_back({Perlin(), settings->second, src.seed, src.dimensions});
+				value.op = DensityProgram::NOISE;
+				value.index = it->second;
+				value.perBlock = (src.dimensions == 3);
+				break ;
+			}
+			case DensityNode::SPLINE:
+				value.op = DensityProgram::SPLINE;
+				value.index = static_cast<uint32_t>(_program._splines.size());
+				_program._splines.push_back(src.spline);
+				break ;
+			case DensityNode::CLAMP:
+				if (src.min > src.max)
+					throw std::runtime_error("densityGraph: node `" + name + "` has a min larger than its max");
+				value.op = DensityProgram::CLAMP;
+				break ;
+			default:
+				value.op = _op(src.type);
+				break ;
+		}
+		for (int input : value.inputs)
+			value.perBlock = value.perBlock || _values[input].perBlock;
+	}
+	else
+		throw std::runtime_error("densityGraph: unknown node `" + name + "`");
+
+	int	id = _add(value);
+	_resolved[name] = id;
+	return (id);
+}
+
+// Folds value if it can be, and returns the id of the value it is the same as, or of the newly added value
+int	DensityCompiler::_add(Value value)
+{
+	bool	foldable = (value.op != DensityProgram::X && value.op != DensityProgram::Y && value.op != DensityProgram::Z
+		&& value.op != DensityProgram::NOISE && value.op != DensityProgram::SPLINE);
+	for (int input : value.inputs)
+		foldable = foldable && _values[input].constant;
+	if (!value.constant && foldable)
+	{
+		value.value = _fold(value);
+		value.constant = true;
+	}
+	if (value.constant)
+	{
+		value.inputs.clear();
+		value.perBlock = false;
+	}
+
+	// Spline values are never merged, every spline node has its own spline
+	Key		key = {value.constant, value.op, value.inputs, value.index, std::bit_cast<uint32_t>(value.value),
+		std::bit_cast<uint32_t>(value.min), std::bit_cast<uint32_t>(value.max)};
+	if (value.constant)
+		key = {true, 0, {}, 0, std::bit_cast<uint32_t>(value.value), 0, 0};
+	auto	[it, added] = _merged.try_emplace(key, static_cast<int>(_values.size()));
+	if (added)
+		_values.push_back(value);
+	return (it->second);
+}
+
+// Same operations as DensityProgram::_run, for a single position
+float	DensityCompiler::_fold(const Value &value) const
+{
+	float	a = value.inputs.size() > 0 ? _values[value.inputs[0]].value : 0.0f;
+	float	b = value.inputs.size() > 1 ? _values[value.inputs[1]].value : 0.0f;
+	float	c = value.inputs.size() > 2 ? _values[value.inputs[2]].value : 0.0f;
+	switch (value.op)
+	{
+		case DensityProgram::ADD:
+			return (a + b);
+		case DensityProgram::SUB:
+			return (a - b);
+		case DensityProgram::MUL:
+			return (a * b);
+		case DensityProgram::MIN:
+			return (std::min(a, b));
+		case DensityProgram::MAX:
+			return (std::max(a, b));
+		case DensityProgram::ABS:
+			return (std::abs(a));
+		case DensityProgram::FLOOR:
+			return (std::floor(a));
+		case DensityProgram::CLAMP:
+			return (std::clamp(a, value.min, value.max));
+		case DensityProgram::THRESHOLD:
+			return ((a > b) ? 1.0f : 0.0f);
+		case DensityProgram::SELECT:
+			return ((a > 0.0f) ? b : c);
+		default:
+			return (0.0f);
+	}
+}
+
+// Adds id and every value it depends on that is in the same part to out
+void	DensityCompiler::_collect(int id, bool perBlock, std::set<int> &out) const
+{
+	const Value	&value = _values[id];
+	if (value.constant || value.perBlock != perBlock || !out.insert(id).second)
+		return ;
+	for (int input : value.inputs)
+		_collect(input, perBlock, out);
+}
+
+
+void	DensityCompiler::_compileColumns()
+{
+	int						height = _resolved.at(_graph.height);
+	int						sand = _resolved.at(_graph.sand);
+	std::set<int>			needed;
+	_collect(height, false, needed);
+	_collect(sand, false, needed);
+	for (int term : _terms)
+		_collect(term, false, needed);
+
+	// Values are added after their inputs, so the ids are already in evaluation order
+	std::vector<Item>		items;
+	std::map<int, size_t>	itemOf;
+	for (int id : needed)
+	{
+		itemOf[id] = items.size();
+		items.push_back({id, false, items.size()});
+		for (int input : _values[id].inputs)
+			if (!_values[input].constant)
+				items[itemOf.at(input)].lastUse = items.size() - 1;
+	}
+	// Outputs and terms are read after the last instruction
+	for (int id : needed)
+		if (id == height || id == sand || std::find(_terms.begin(), _terms.end(), id) != _terms.end())
+			items[itemOf.at(id)].lastUse = std::numeric_limits<size_t>::max();
+
+	_allocate(items);
+	for (const Item &item : items)
+		if (_values[item.value].op == DensityProgram::NOISE)
+			_program._columnNoises.push_back(_values[item.value].index);
+	if (_program._columnNoises.size() > DENSITY_COLUMN_NOISES)
+		throw std::runtime_error("densityGraph: the height and sand outputs can't use more than " + std::to_string(DENSITY_COLUMN_NOISES) + " 2D noises");
+	for (const Item &item : items)
+		_program._columnCode.push_back(_instruction(item, items, itemOf, itemOf));
+	_program._height = _operand(height, items, itemOf);
+	_program._sand = _operand(sand, items, itemOf);
+	for (int term : _terms)
+		_program._terms.push_back(_operand(term, items, itemOf));
+}
+
+void	DensityCompiler::_compileBlocks()
+{
+	std::vector<Item>		items;
+	std::map<int, size_t>	valueItems;
+	std::map<int, size_t>	termItems;
+	std::vector<size_t>		segmentEnds;
+	// Column values are loaded into a block register right before the first item that reads them
+	auto	load = [&](int id) {
+		if (!_values[id].constant && !_values[id].perBlock && termItems.try_emplace(id, items.size()).second)
+			items.push_back({id, true, items.size()});
+	};
+	// Keeps the register of id until the last item
+	auto	use = [&](int id) {
+		if (!_values[id].constant)
+			items[_values[id].perBlock ? valueItems.at(id) : termItems.at(id)].lastUse = items.size() - 1;
+	};
+
+	for (const std::string &cave : _graph.caves)
+	{
+		int				output = _resolved.at(cave);
+		std::set<int>	needed;
+		_collect(output, true, needed);
+		for (int id : needed)
+		{
+			if (valueItems.count(id))
+				continue ;
+			for (int input : _values[id].inputs)
+				load(input);
+			valueItems[id] = items.size();
+			items.push_back({id, false, items.size()});
+			for (int input : _values[id].inputs)
+				use(input);
+		}
+		// The output is read at the end of its segment
+		load(output);
+		use(output);
+		segmentEnds.push_back(items.size());
+	}
+
+	_allocate(items);
+	for (const Item &item : items)
+		if (!item.term && _values[item.value].op == DensityProgram::NOISE)
+			_program._blockNoises.push_back(_values[item.value].index);
+	if (_program._blockNoises.size() > DENSITY_BLOCK_NOISES)
+		throw std::runtime_error("densityGraph: the cave outputs can't use more than " + std::to_string(DENSITY_BLOCK_NOISES) + " 3D noises");
+
+	size_t	start = 0;
+	for (size_t s = 0; s < segmentEnds.size(); ++s)
+	{
+		DensityProgram::Segment	segment;
+		int						output = _resolved.at(_graph.caves[s]);
+		for (size_t i = start; i < segmentEnds[s]; ++i)
+			segment.code.push_back(_instruction(items[i], items, valueItems, termItems));
+		segment.output = _operand(output, items, _values[output].perBlock ? valueItems : termItems);
+		// Registers that are still read after this segment, they are compacted along with the blocks
+		for (size_t i = 0; i < segmentEnds[s]; ++i)
+			if (items[i].lastUse >= segmentEnds[s])
+				segment.live.push_back(items[i].reg);
+		_program._segments.push_back(std::move(segment));
+		start = segmentEnds[s];
+	}
+}
+
+// Gives every item a register, a register is free again after the last item that reads it
+void	DensityCompiler::_allocate(std::vector<Item> &items) const
+{
+	// The parts are evaluated separately, so they can use the same registers
+	uint32_t							count = static_cast<uint32_t>(_program._registerCount);
+	std::vector<uint32_t>				free;
+	std::vector<std::vector<size_t>>	released(items.size());
+	for (uint32_t reg = count; reg > 0; --reg)
+		free.push_back(reg - 1);
+	for (size_t i = 0; i < items.size(); ++i)
+		if (items[i].lastUse < items.size())
+			released[items[i].lastUse].push_back(i);
+
+	for (size_t i = 0; i < items.size(); ++i)
+	{
+		// Inputs are read before the result is written, so the result can go in a register freed here
+		for (size_t j : released[i])
+			if (j != i)
+				free.push_back(items[j].reg);
+		if (free.empty())
+			free.push_back(count++);
+		items[i].reg = free.back();
+		free.pop_back();
+		if (items[i].lastUse == i)
+			free.push_back(items[i].reg);
+	}
+	if (count > DENSITY_REGISTERS)
+		throw std::runtime_error("densityGraph: needs more than " + std::to_string(DENSITY_REGISTERS) + " registers");
+	_program._registerCount = count;
+}
+
+DensityProgram::Operand	DensityCompiler::_operand(int id, const std::vector<Item> &items, const std::map<int, size_t> &itemOf) const
+{
+	DensityProgram::Operand	ret;
+	if (_values[id].constant)
+	{
+		ret.value = _values[id].value;
+		return (ret);
+	}
+	ret.constant = false;
+	ret.reg = items[itemOf.at(id)].reg;
+	return (ret);
+}
+
+// Column values are read from termItems, which is the same as valueItems in the column part
+DensityProgram::Instruction	DensityCompiler::_instruction(const Item &item, const std::vector<Item> &items, const std::map<int, size_t> &valueItems, const std::map<int, size_t> &termItems) const
+{
+	const Value					&value = _values[item.value];
+	DensityProgram::Instruction	ret;
+	ret.dst = item.reg;
+	if (item.term)
+	{
+		ret.op = DensityProgram::TERM;
+		ret.index = static_cast<uint32_t>(std::find(_terms.begin(), _terms.end(), item.value) - _terms.begin());
+		return (ret);
+	}
+	ret.op = value.op;
+	ret.index = value.index;
+	ret.min = value.min;
+	ret.max = value.max;
+	const std::vector<uint32_t>	&noises = value.perBlock ? _program._blockNoises : _program._columnNoises;
+	if (value.op == DensityProgram::NOISE)
+		ret.slot = static_cast<uint32_t>(std::find(noises.begin(), noises.end(), value.index) - noises.begin());
+	for (size_t i = 0; i < value.inputs.size(); ++i)
+	{
+		int	input = value.inputs[i];
+		ret.inputs[i] = _operand(input, items, _values[input].perBlock ? valueItems : termItems);
+	}
+	return (ret);
+}
+
+DensityProgram::DensityProgram()
+{
+}
+
+DensityProgram::DensityProgram(const DensityGraph &graph, const std::map<std::string, NoiseSettings> &noises, const std::map<std::string, float> &constants)
+{
+	DensityCompiler	compiler(graph, noises, constants, *this);
+	compiler.compile();
+}
+
+DensityProgram::~DensityProgram()
+{
+}
+
+void	DensityProgram::setSeed(uint64_t seed)
+{
+	for (Noise &noise : _noises)
+		noise.sampler.setSeed(seed + noise.seed);
+}
+
+void	DensityProgram::setSplineResolution(uint64_t resolution)
+{
+	for (Noise &noise : _noises)
+		noise.settings.spline.setResolution(resolution);
+	for (Spline &spline : _splines)
+		spline.setResolution(resolution);
+}
+
+void	DensityProgram::getColumns(const float *xs, const float *zs, const float *const *noises, float *heights, float *sand, float *terms, size_t count) const
+{
+	Registers	registers;
+	size_t		lanes[DENSITY_BATCH_SIZE];
+	for (size_t i = 0; i < count; ++i)
+		lanes[i] = i;
+	Context		context = {xs, nullptr, zs, nullptr, noises, lanes};
+	for (const Instruction &instruction : _columnCode)
+		_run(instruction, registers, context, count);
+
+	float	broadcast[DENSITY_BATCH_SIZE];
+	std::copy_n(_load(_height, registers, broadcast, count), count, heights);
+	std::copy_n(_load(_sand, registers, broadcast, count), count, sand);
+	for (size_t t = 0; t < _terms.size(); ++t)
+	{
+		const float	*values = _load(_terms[t], registers, broadcast, count);
+		for (size_t i = 0; i < count; ++i)
+			terms[i * DENSITY_COLUMN_TERMS + t] = values[i];
+	}
+}
+
+size_t	DensityProgram::getCaves(const float *terms, float x, float z, const float *ys, const float *const *noises, size_t *out, size_t count) const
+{
+	if (_segments.empty())
+		return (0);
+	Registers	registers;
+	float		xs[DENSITY_BATCH_SIZE];
+	float		laneYs[DENSITY_BATCH_SIZE];
+	float		zs[DENSITY_BATCH_SIZE];
+	size_t		lanes[DENSITY_BATCH_SIZE];
+	for (size_t i = 0; i < count; ++i)
+	{
+		xs[i] = x;
+		laneYs[i] = ys[i];
+		zs[i] = z;
+		lanes[i] = i;
+	}
+	Context		context = {xs, laneYs, zs, terms, noises, lanes};
+
+	for (const Segment &segment : _segments)
+	{
+		for (const Instruction &instruction : segment.code)
+			_run(instruction, registers, context, count);
+		// Only the blocks that can still be caves are evaluated by the next segment
+		float		broadcast[DENSITY_BATCH_SIZE];
+		const float	*output = _load(segment.output, registers, broadcast, count);
+		size_t		kept = 0;
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (output[i] > 0.0f)
+				continue ;
+			for (uint32_t reg : segment.live)
+				registers[reg][kept] = registers[reg][i];
+			laneYs[kept] = laneYs[i];
+			lanes[kept] = lanes[i];
+			kept++;
+		}
+		count = kept;
+		if (count == 0)
+			break ;
+	}
+	std::copy_n(lanes, count, out);
+	return (count);
+}
+
+size_t	DensityProgram::getColumnNoiseCount() const
+{
+	return (_columnNoises.size());
+}
+
+void	DensityProgram::getColumnNoise(size_t index, const float *xs, const float *zs, float *out, size_t count) const
+{
+	const Noise	&noise = _noises[_columnNoises[index]];
+	TerrainGenerator::noise2D(noise.sampler, noise.settings, xs, zs, out, count);
+}
+
+size_t	DensityProgram::getBlockNoiseCount() const
+{
+	return (_blockNoises.size());
+}
+
+void	DensityProgram::getBlockNoise(size_t index, const float *xs, const float *ys, const float *zs, float *out, size_t count) const
+{
+	const Noise	&noise = _noises[_blockNoises[index]];
+	TerrainGenerator::noise3D(noise.sampler, noise.settings, xs, ys, zs, out, count);
+}
+
+size_t	DensityProgram::getColumnInstructionCount() const
+{
+	return (_columnCode.size());
+}
+
+size_t	DensityProgram::getBlockInstructionCount() const
+{
+	size_t	ret = 0;
+	for (const Segment &segment : _segments)
+		ret += segment.code.size();
+	return (ret);
+}
+
+size_t	DensityProgram::getRegisterCount() const
+{
+	return (_registerCount);
+}
+
+void	DensityProgram::_run(const Instruction &instruction, Registers &registers, const Context &context, size_t count) const
+{
+	float	*out = registers[instruction.dst];
+	float	broadcast[3][DENSITY_BATCH_SIZE];
+	auto	input = [&](int i) {
+		return (_load(instruction.inputs[i], registers, broadcast[i], count));
+	};
+
+	switch (instruction.op)
+	{
+		case X:
+			std::copy_n(context.xs, count, out);
+			break ;
+		case Y:
+			std::copy_n(context.ys, count, out);
+			break ;
+		case Z:
+			std::copy_n(context.zs, count, out);
+			break ;
+		case TERM:
+			std::fill_n(out, count, context.terms[instruction.index]);
+			break ;
+		case NOISE:
+		{
+			const Noise	&noise = _noises[instruction.index];
+			// 2D noises are only in the column part and 3D noises only in the block part, so the slot is of the right kind
+			if (context.noises)
+				for (size_t i = 0; i < count; ++i)
+					out[i] = context.noises[instruction.slot][context.lanes[i]];
+			else if (noise.dimensions == 2)
+				TerrainGenerator::noise2D(noise.sampler, noise.settings, context.xs, context.zs, out, count);
+			else
+				TerrainGenerator::noise3D(noise.sampler, noise.settings, context.xs, context.ys, context.zs, out, count);
+			break ;
+		}
+		case SPLINE:
+		{
+			_splines[instruction.index].evaluate(input(0), out, count);
+			break ;
+		}
+		case ADD:
+			_apply(out, instruction.inputs[0], instruction.inputs[1], registers, count, [](float a, float b) {return (a + b);});
+			break ;
+		case SUB:
+			_apply(out, instruction.inputs[0], instruction.inputs[1], registers, count, [](float a, float b) {return (a - b);});
+			break ;
+		case MUL:
+			_apply(out, instruction.inputs[0], instruction.inputs[1], registers, count, [](float a, float b) {return (a * b);});
+			break ;
+		case MIN:
+			_apply(out, instruction.inputs[0], instruction.inputs[1], registers, count, [](float a, float b) {return (std::min(a, b));});
+			break ;
+		case MAX:
+			_apply(out, instruction.inputs[0], instruction.inputs[1], registers, count, [](float a, float b) {return (std::max(a, b));});
+			break ;
+		case ABS:
+			_apply(out, instruction.inputs[0], Operand(), registers, count, [](float a, float) {return (std::abs(a));});
+			break ;
+		case FLOOR:
+			_apply(out, instruction.inputs[0], Operand(), registers, count, [](float a, float) {return (std::floor(a));});
+			break ;
+		case CLAMP:
+		{
+			float	min = instruction.min;
+			float	max = instruction.max;
+			_apply(out, instruction.inputs[0], Operand(), registers, count, [=](float a, float) {return (std::clamp(a, min, max));});
+			break ;
+		}
+		case THRESHOLD:
+			_apply(out, instruction.inputs[0], instruction.inputs[1], registers, count, [](float a, float b) {return ((a > b) ? 1.0f : 0.0f);});
+			break ;
+		case SELECT:
+		{
+			const float	*a = input(0);
+			const float	*b = input(1);
+			const float	*c = input(2);
+			for (size_t i = 0; i < count; ++i)
+				out[i] = (a[i] > 0.0f) ? b[i] : c[i];
+			break ;
+		}
+	}
+}
+
+// Calls function for every position, a constant input is passed as is instead of being broadcast first
+template <typename Function>
+void	DensityProgram::_apply(float *out, const Operand &a, const Operand &b, Registers &registers, size_t count, Function function)
+{
+	const float	*valuesA = registers[a.reg];
+	const float	*valuesB = registers[b.reg];
+	if (b.constant)
+	{
+		for (size_t i = 0; i < count; ++i)
+			out[i] = function(valuesA[i], b.value);
+	}
+	else if (a.constant)
+	{
+		for (size_t i = 0; i < count; ++i)
+			out[i] = function(a.value, valuesB[i]);
+	}
+	else
+	{
+		for (size_t i = 0; i < count; ++i)
+			out[i] = function(valuesA[i], valuesB[i]);
+	}
+}
+
+const float	*DensityProgram::_load(const Operand &operand, Registers &registers, float *broadcast, size_t count)
+{
+	if (!operand.constant)
+		return (registers[operand.reg]);
+	std::fill_n(broadcast, count, operand.value);
+	return (broadcast);
+}
@@ -0,0 +1,212 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "JobSystem.hpp"
+
+#include <algorithm>
+
+// Job system and index of the worker running on this thread, nullptr for threads that aren't workers
+static thread_local const JobSystem	*workerSystem = nullptr;
+static thread_local size_t			workerIndex = 0;
+
+JobSystem::JobSystem()
+{}
+
+JobSystem::~JobSystem()
+{
+	stop();
+}
+
+void	JobSystem::start(int threadCount)
+{
+	_running = true;
+	_workers.reserve(threadCount);
+	for (int i = 0; i < threadCount; ++i)
+		_workers.push_back(std::make_unique<Worker>());
+	_threads.reserve(threadCount);
+	for (int i = 0; i < threadCount; ++i)
+		_threads.emplace_back(&JobSystem::_routine, this, i);
+}
+
+void	JobSystem::stop()
+{
+	_sleepMtx.lock();
+	_running = false;
+	_sleepMtx.unlock();
+	_wake.notify_all();
+	for (auto &thread : _threads)
+		thread.join();
+	_threads.clear();
+	_workers.clear();
+	_pending = 0;
+}
+
+void	JobSystem::submit(Job job, size_t priority, uint64_t key)
+{
+	if (_workers.empty())
+		return ;
+	priority = std::min(priority, PRIORITY_COUNT - 1);
+	// Jobs submitted from a worker stay on that worker, others are spread round robin
+	size_t	index = (workerSystem == this) ? workerIndex : _nextWorker++ % _workers.size();
+	Worker	&worker = *_workers[index];
+	// Counted before the job is published, a thief can pop it right after the push and the count can't go below 0
+	_pending++;
+	_lockWorker(worker);
+	worker.jobs[priority].push_back({std::move(job), key});
+	if (priority < worker.lowest)
+		worker.lowest = priority;
+	worker.mtx.unlock();
+	// A worker counts itself as sleeping before it checks _pending, so either it sees the job or it is seen here.
+	// Taking the lock waits until it is inside wait(), so the notify can't land before it
+	if (_sleeping > 0)
+	{
+		_sleepMtx.lock();
+		_sleepMtx.unlock();
+		_wake.notify_one();
+	}
+}
+
+void	JobSystem::reprioritize(const Reprioritizer &reprioritizer)
+{
+	std::vector<QueuedJob>	jobs;
+	std::vector<size_t>		priorities;
+	for (std::unique_ptr<Worker> &worker : _workers)
+	{
+		_lockWorker(*worker);
+		jobs.clear();
+		for (std::deque<QueuedJob> &queue : worker->jobs)
+		{
+			for (QueuedJob &queued : queue)
+				jobs.push_back(std::move(queued));
+			queue.clear();
+		}
+		// Called in the order the jobs would have run, so jobs that end up at the same priority keep that order
+		for (QueuedJob &queued : jobs)
+		{
+			size_t	priority = reprioritizer(queued.key);
+			if (priority == CANCELLED)
+			{
+				_pending--;
+				continue ;
+			}
+			worker->jobs[std::min(priority, PRIORITY_COUNT - 1)].push_back(std::move(queued));
+		}
+		_updateLowest(*worker);
+		worker->mtx.unlock();
+	}
+}
+
+uint64_t	JobSystem::getPendingCount() const
+{
+	return (_pending);
+}
+
+int	JobSystem::getThreadCount() const
+{
+	return (static_cast<int>(_threads.size()));
+}
+
+uint64_t	JobSystem::getStealCount() const
+{
+	return (_steals);
+}
+
+uint64_t	JobSystem::getContendedCount() const
+{
+	return (_contended);
+}
+
+uint64_t	JobSystem::getLockCount() const
+{
+	return (_locks);
+}
+
+void	JobSystem::_lockWorker(Worker &worker)
+{
+	_locks.fetch_add(1, std::memory_order_relaxed);
+	if (worker.mtx.try_lock())
+		return ;
+	_contended.fetch_add(1, std::memory_order_relaxed);
+	worker.mtx.lock();
+}
+
+void	JobSystem::_updateLowest(Worker &worker)
+{
+	size_t	priority = 0;
+	while (priority < PRIORITY_COUNT && worker.jobs[priority].empty())
+		priority++;
+	worker.lowest = priority;
+}
+
+/*
+// Takes the oldest job of the lowest priority of this worker, or steals the newest job of the lowest priority
+// of the worker that has the lowest one. Only the chosen worker is locked
+*/
+bool	JobSystem::_popJob(size_t index, Job &job)
+{
+	while (true)
+	{
+		size_t	best = index;
+		size_t	bestPriority = _workers[index]->lowest;
+		for (size_t i = 1; i < _workers.size(); ++i)
+		{
+			size_t	other = (index + i) % _workers.size();
+			size_t	priority = _workers[other]->lowest;
+			if (priority < bestPriority)
+			{
+				best = other;
+				bestPriority = priority;
+			}
+		}
+		if (bestPriority == PRIORITY_COUNT)
+			return (false);
+
+		Worker	&worker = *_workers[best];
+		_lockWorker(worker);
+		size_t	priority = worker.lowest;
+		// Taken by another worker since, look again
+		if (priority == PRIORITY_COUNT)
+		{
+			worker.mtx.unlock();
+			continue ;
+		}
+		std::deque<QueuedJob>	&queue = worker.jobs[priority];
+		if (best == index)
+		{
+			job = std::move(queue.front().job);
+			queue.pop_front();
+		}
+		else
+		{
+			job = std::move(queue.back().job);
+			queue.pop_back();
+			_steals.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (queue.empty())
+			_updateLowest(worker);
+		worker.mtx.unlock();
+		_pending--;
+		return (true);
+	}
+}
+
+void	JobSystem::_routine(size_t index)
+{
+	workerSystem = this;
+	workerIndex = index;
+	while (_running)
+	{
+		Job	job;
+		if (_popJob(index, job))
+		{
+			job();
+			continue ;
+		}
+		std::unique_lock<std::mutex>	lock(_sleepMtx);
+		_sleeping++;
+		_wake.wait(lock, [this]() {return (_pending > 0 || !_running);});
+		_sleeping--;
+	}
+}
@@ -6,6 +6,63 @@ Created on: 20/10/2025
 #include "TerrainGenerator.hpp"
 #include "Perlin.hpp"
 
+#include <algorithm>
+
+// Most positions a batch function handles at once, larger batches are split
+constexpr size_t	NOISE_BATCH_SIZE = 64;
+
+// Closest lattice coordinate at or below value
+static int	latticeFloor(int value, int step)
+{
+	int	ret = value / step * step;
+	return ((ret > value) ? ret - step : ret);
+}
+
+// Position of value inside its lattice cell, from 0 to 1
+static float	latticeFraction(int value, int cell, int step)
+{
+	return (static_cast<float>(value - cell) / static_cast<float>(step));
+}
+
+void	CaveLattice::getColumn(int x, int z, int y, float *const *values, size_t count) const
+{
+	int		cellX = latticeFloor(x, step);
+	int		cellZ = latticeFloor(z, step);
+	float	fx = latticeFraction(x, cellX, step);
+	float	fz = latticeFraction(z, cellZ, step);
+	size_t	strideY = size.x;
+	size_t	strideZ = size.x * size.y;
+	size_t	column = (cellZ - origin.z) / step * strideZ + (cellX - origin.x) / step;
+
+	// A noise at a lattice height, interpolated to x and z
+	auto	level = [&](const std::vector<float> &noise, int latticeY) {
+		const float	*v = &noise[column + latticeY * strideY];
+		float		low = v[0] + (v[1] - v[0]) * fx;
+		float		high = v[strideZ] + (v[strideZ + 1] - v[strideZ]) * fx;
+		return (low + (high - low) * fz);
+	};
+
+	size_t	i = 0;
+	while (i < count)
+	{
+		int		cellY = latticeFloor(y + static_cast<int>(i), step);
+		int		latticeY = (cellY - origin.y) / step;
+		size_t	cellEnd = std::min(count, i + static_cast<size_t>(cellY + step - y - static_cast<int>(i)));
+		for (size_t n = 0; n < noises.size(); ++n)
+		{
+			float	bottom = level(noises[n], latticeY);
+			float	top = level(noises[n], latticeY + 1);
+			// Only the y interpolation is left for the blocks in this cell
+			for (size_t j = i; j < cellEnd; ++j)
+			{
+				float	fy = latticeFraction(y + static_cast<int>(j), cellY, step);
+				values[n][j] = bottom + (top - bottom) * fy;
+			}
+		}
+		i = cellEnd;
+	}
+}
+
 TerrainGenerator::TerrainGenerator()
 {
 }
@@ -18,102 +75,237 @@ TerrainGenerator::TerrainGenerator(const TerrainGeneratorDTO &dto):
 	_sandBeachThreshold(dto.sandBeachThreshold),
 	_sandSeaThreshold(dto.sandSeaThreshold),
 	_sand(dto.sand),
-	_continentalness(dto.continentalness)
+	_continentalness(dto.continentalness),
+	_latticeStep(dto.latticeStep),
+	_graph(dto.densityGraph)
 {
+	setSeed(_seed);
+	setSplineResolution(static_cast<uint64_t>(dto.splineResolution));
 }
 
 TerrainGenerator::~TerrainGenerator()
 {
 }
 
-int	TerrainGenerator::getTerrainHeight(perlinSamplers &samplers, const mlm::ivec2 &pos)
+int	TerrainGenerator::getTerrainHeight(const mlm::ivec2 &pos) const
 {
-	float	height = 0.0f;
-
-	height += noise2D(samplers.height, _continentalness, static_cast<mlm::vec2>(pos));
-	return (static_cast<int>(height));
+	return (_getColumn(pos).height);
 }
 
-int	TerrainGenerator::getTerrainHeight(perlinSamplers &samplers, const mlm::ivec3 &pos)
+int	TerrainGenerator::getTerrainHeight(const mlm::ivec3 &pos) const
 {
-	return (getTerrainHeight(samplers, mlm::ivec2(pos.x, pos.z)));
+	return (getTerrainHeight(mlm::ivec2(pos.x, pos.z)));
 }
 
-Block	TerrainGenerator::getBlock(perlinSamplers &samplers, const mlm::ivec3 &pos, int terrainHeight)
+Block	TerrainGenerator::getBlock(const mlm::ivec3 &pos) const
 {
-	Block::Type	type = Block::STONE;
-	bool		underwater = false;
-	bool		sand = isSand(samplers, mlm::ivec2(pos.x, pos.z), terrainHeight);
+	Block	ret;
+	getBlocks(_getColumn(mlm::ivec2(pos.x, pos.z)), CaveLattice(), pos, &ret, 1);
+	return (ret);
+}
 
-	if (pos.y > terrainHeight)
-		type = Block::AIR;
+// Whether the cave outputs carve out pos, it doesn't matter if the block there is solid
+bool	TerrainGenerator::isCave(const mlm::ivec3 &pos) const
+{
+	if (pos.y == 0)
+		return (false);
+	TerrainColumn	column = _getColumn(mlm::ivec2(pos.x, pos.z));
+	float			y = static_cast<float>(pos.y);
+	size_t			carved;
+	return (_program.getCaves(column.terms.data(), static_cast<float>(pos.x), static_cast<float>(pos.z), &y, nullptr, &carved, 1) == 1);
+}
 
-	if (pos.y <= _seaLevel && terrainHeight < _seaLevel)
-		underwater = true;
+bool	TerrainGenerator::isSand(const mlm::ivec2 &pos) const
+{
+	return (_getColumn(pos).sand);
+}
 
-	if (pos.y == terrainHeight)
+void	TerrainGenerator::getTerrainHeights(const mlm::ivec2 &pos, int *out, size_t count) const
+{
+	for (size_t start = 0; start < count; start += DENSITY_BATCH_SIZE)
 	{
-
-		if (sand)
-			type = Block::SAND;
-		else
-			type = underwater ? Block::DIRT : Block::GRASS;
+		size_t			batch = std::min(count - start, DENSITY_BATCH_SIZE);
+		float			xs[DENSITY_BATCH_SIZE];
+		float			zs[DENSITY_BATCH_SIZE];
+		TerrainColumn	columns[DENSITY_BATCH_SIZE];
+		for (size_t i = 0; i < batch; ++i)
+		{
+			xs[i] = static_cast<float>(pos.x + static_cast<int>(start + i));
+			zs[i] = static_cast<float>(pos.y);
+		}
+		_evaluateColumns(xs, zs, nullptr, columns, batch);
+		for (size_t i = 0; i < batch; ++i)
+			out[start + i] = columns[i].height;
 	}
-	else if (pos.y < terrainHeight && pos.y > terrainHeight - 4)
+}
+
+/*
+// With a lattice the 2D noises of the program are sampled every latticeStep columns and interpolated bilinearly,
+// the rest of the column part still runs for every column
+*/
+void	TerrainGenerator::getColumns(const mlm::ivec2 &pos, const mlm::ivec2 &size, TerrainColumn *out) const
+{
+	size_t	count = size.x * size.y;
+	size_t	width = size.x;
+
+	int								step = (_latticeStep > 1) ? _latticeStep : 0;
+	mlm::ivec2						origin;
+	mlm::ivec2						latticeSize;
+	std::vector<std::vector<float>>	lattice;
+	if (step > 0)
 	{
-		if (sand)
-			type = Block::SAND;
-		else
-			type = Block::DIRT;
+		origin = mlm::ivec2(latticeFloor(pos.x, step), latticeFloor(pos.y, step));
+		// One point past the last column, so every column has a cell around it
+		latticeSize = mlm::ivec2((pos.x + size.x - 1 - origin.x) / step + 2, (pos.y + size.y - 1 - origin.y) / step + 2);
+		size_t				points = latticeSize.x * latticeSize.y;
+		std::vector<float>	xs(points);
+		std::vector<float>	zs(points);
+		for (size_t i = 0; i < points; ++i)
+		{
+			xs[i] = static_cast<float>(origin.x + static_cast<int>(i % latticeSize.x) * step);
+			zs[i] = static_cast<float>(origin.y + static_cast<int>(i / latticeSize.x) * step);
+		}
+		lattice.resize(_program.getColumnNoiseCount());
+		for (size_t n = 0; n < lattice.size(); ++n)
+		{
+			lattice[n].resize(points);
+			_program.getColumnNoise(n, xs.data(), zs.data(), lattice[n].data(), points);
+		}
 	}
 
-	// Only check for caves if block type is solid
-	if (type != Block::AIR)
-		if (isCave(samplers, pos))
-			type = Block::AIR;
+	for (size_t start = 0; start < count; start += DENSITY_BATCH_SIZE)
+	{
+		size_t	batch = std::min(count - start, DENSITY_BATCH_SIZE);
+		float	xs[DENSITY_BATCH_SIZE];
+		float	zs[DENSITY_BATCH_SIZE];
+		float	values[DENSITY_COLUMN_NOISES][DENSITY_BATCH_SIZE];
+		float	*noises[DENSITY_COLUMN_NOISES];
+		for (size_t i = 0; i < batch; ++i)
+		{
+			int	x = pos.x + static_cast<int>((start + i) % width);
+			int	z = pos.y + static_cast<int>((start + i) / width);
+			xs[i] = static_cast<float>(x);
+			zs[i] = static_cast<float>(z);
+			if (step == 0)
+				continue ;
+			int			cellX = latticeFloor(x, step);
+			int			cellZ = latticeFloor(z, step);
+			float		fx = latticeFraction(x, cellX, step);
+			float		fz = latticeFraction(z, cellZ, step);
+			size_t		cell = (cellZ - origin.y) / step * latticeSize.x + (cellX - origin.x) / step;
+			for (size_t n = 0; n < lattice.size(); ++n)
+			{
+				const float	*v = &lattice[n][cell];
+				float		low = v[0] + (v[1] - v[0]) * fx;
+				float		high = v[latticeSize.x] + (v[latticeSize.x + 1] - v[latticeSize.x]) * fx;
+				values[n][i] = low + (high - low) * fz;
+			}
+		}
+		for (size_t n = 0; n < DENSITY_COLUMN_NOISES; ++n)
+			noises[n] = values[n];
+		_evaluateColumns(xs, zs, (step > 0) ? noises : nullptr, out + start, batch);
+	}
+}
 
-	if (type == Block::AIR && underwater)
-		type = Block::WATER;
+CaveLattice	TerrainGenerator::getCaveLattice(const mlm::ivec3 &pos, const mlm::ivec3 &size) const
+{
+	CaveLattice	ret;
+	if (_latticeStep <= 1)
+		return (ret);
+	ret.step = _latticeStep;
+	ret.origin = mlm::ivec3(latticeFloor(pos.x, _latticeStep), latticeFloor(pos.y, _latticeStep), latticeFloor(pos.z, _latticeStep));
+	// One point past the last block, so every block has a cell around it
+	ret.size = mlm::ivec3(
+		(pos.x + size.x - 1 - ret.origin.x) / _latticeStep + 2,
+		(pos.y + size.y - 1 - ret.origin.y) / _latticeStep + 2,
+		(pos.z + size.z - 1 - ret.origin.z) / _latticeStep + 2);
 
-	Block ret(type);
+	size_t				count = ret.size.x * ret.size.y * ret.size.z;
+	std::vector<float>	xs(count);
+	std::vector<float>	ys(count);
+	std::vector<float>	zs(count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		xs[i] = static_cast<float>(ret.origin.x + static_cast<int>(i % ret.size.x) * _latticeStep);
+		ys[i] = static_cast<float>(ret.origin.y + static_cast<int>(i / ret.size.x % ret.size.y) * _latticeStep);
+		zs[i] = static_cast<float>(ret.origin.z + static_cast<int>(i / (ret.size.x * ret.size.y)) * _latticeStep);
+	}
+	ret.noises.resize(_program.getBlockNoiseCount());
+	for (size_t i = 0; i < ret.noises.size(); ++i)
+	{
+		ret.noises[i].resize(count);
+		_program.getBlockNoise(i, xs.data(), ys.data(), zs.data(), ret.noises[i].data(), count);
+	}
 	return (ret);
 }
 
-bool	TerrainGenerator::isCave(perlinSamplers &samplers, const mlm::ivec3 &pos)
+void	TerrainGenerator::getBlocks(const TerrainColumn &column, const CaveLattice &caves, const mlm::ivec3 &pos, Block *out, size_t count) const
 {
-	if (pos.y == 0)
-		return (false);
-	float	val1 = noise3D(samplers.cave1, _cave, pos);
-	if (std::abs(val1) > _caveDiameter)
-		return (false);
-	float	val2 = noise3D(samplers.cave2, _cave, pos);
-	if (std::abs(val2) > _caveDiameter)
-		return (false);
-	return (true);
+	int		height = column.height;
+	int		bottom = pos.y;
+	int		top = pos.y + static_cast<int>(count);
+	// Sets the blocks from y = from up to, not including, y = to that are in this part of the column
+	auto	fill = [&](int from, int to, Block::Type type) {
+		from = std::max(from, bottom);
+		to = std::min(to, top);
+		if (from < to)
+			std::fill(out + (from - bottom), out + (to - bottom), Block(type));
+	};
+
+	fill(bottom, height - 3, Block::STONE);
+	fill(height - 3, height, column.sand ? Block::SAND : Block::DIRT);
+	fill(height, height + 1, _getTerrainType(height, height, column.sand));
+	fill(height + 1, top, Block::AIR);
+	if (height < _seaLevel)
+		fill(height + 1, _seaLevel + 1, Block::WATER);
+
+	// Caves only carve out the solid blocks, and never the bottom layer
+	int		caveBottom = std::max(bottom, 1);
+	int		caveTop = std::min(top, height + 1);
+	for (int start = caveBottom; start < caveTop; start += static_cast<int>(DENSITY_BATCH_SIZE))
+	{
+		size_t			batch = std::min(static_cast<size_t>(caveTop - start), DENSITY_BATCH_SIZE);
+		float			ys[DENSITY_BATCH_SIZE];
+		float			values[DENSITY_BLOCK_NOISES][DENSITY_BATCH_SIZE];
+		float			*noises[DENSITY_BLOCK_NOISES];
+		size_t			carved[DENSITY_BATCH_SIZE];
+		for (size_t i = 0; i < batch; ++i)
+			ys[i] = static_cast<float>(start + static_cast<int>(i));
+		// With a lattice the noises are interpolated up front, otherwise the program samples them
+		if (caves.step > 0)
+		{
+			for (size_t n = 0; n < DENSITY_BLOCK_NOISES; ++n)
+				noises[n] = values[n];
+			caves.getColumn(pos.x, pos.z, start, noises, batch);
+		}
+		size_t	carvedCount = _program.getCaves(column.terms.data(), static_cast<float>(pos.x), static_cast<float>(pos.z), ys,
+			(caves.step > 0) ? noises : nullptr, carved, batch);
+		for (size_t i = 0; i < carvedCount; ++i)
+		{
+			int	y = start + static_cast<int>(carved[i]);
+			out[y - bottom] = Block(_isUnderwater(y, height) ? Block::WATER : Block::AIR);
+		}
+	}
 }
 
-bool	TerrainGenerator::isSand(perlinSamplers &samplers, const mlm::ivec2 &pos, int terrainHeight)
+const perlinSamplers	&TerrainGenerator::getSamplers() const
 {
-	if (terrainHeight > _seaLevel + 2)
-		return (false);
-	float	threshold = (terrainHeight > _seaLevel - 2) ? _sandBeachThreshold : _sandSeaThreshold;
-	float	val = noise2D(samplers.sand, _sand, pos);
-	return (val > threshold);
+	return (_samplers);
 }
 
-perlinSamplers	TerrainGenerator::getSamplers()
+const DensityProgram	&TerrainGenerator::getDensityProgram() const
 {
-	perlinSamplers	ret;
-	ret.height.setSeed(_seed);
-	ret.cave1.setSeed(_seed);
-	ret.cave2.setSeed(_seed + 1);
-	ret.sand.setSeed(_seed);
-	return (ret);
+	return (_program);
 }
 
 void	TerrainGenerator::setSeed(uint64_t seed)
 {
 	_seed = seed;
+	_samplers.height.setSeed(_seed);
+	_samplers.cave1.setSeed(_seed);
+	_samplers.cave2.setSeed(_seed + 1);
+	_samplers.sand.setSeed(_seed);
+	_program.setSeed(_seed);
 }
 
 uint64_t	TerrainGenerator::getSeed() const
@@ -121,9 +313,29 @@ uint64_t	TerrainGenerator::getSeed() const
 	return (_seed);
 }
 
+void	TerrainGenerator::setSplineResolution(uint64_t resolution)
+{
+	_splineResolution = resolution;
+	_continentalness.spline.setResolution(resolution);
+	_cave.spline.setResolution(resolution);
+	_sand.spline.setResolution(resolution);
+	_compile();
+}
+
+void	TerrainGenerator::setLatticeStep(int latticeStep)
+{
+	_latticeStep = latticeStep;
+}
+
+int	TerrainGenerator::getLatticeStep() const
+{
+	return (_latticeStep);
+}
+
 void	TerrainGenerator::setSeaLevel(int seaLevel)
 {
 	_seaLevel = seaLevel;
+	_compile();
 }
 
 int	TerrainGenerator::getSeaLevel() const
@@ -134,6 +346,8 @@ int	TerrainGenerator::getSeaLevel() const
 void	TerrainGenerator::setContinentalnessSpline(const Spline &spline)
 {
 	_continentalness.spline = spline;
+	_continentalness.spline.setResolution(_splineResolution);
+	_compile();
 }
 
 const Spline	&TerrainGenerator::getContinentalnessSpline() const
@@ -141,17 +355,53 @@ const Spline	&TerrainGenerator::getContinentalnessSpline() const
 	return (_continentalness.spline);
 }
 
-float	TerrainGenerator::noise2D(Perlin &sampler, const NoiseSettings &settings, const mlm::vec2 &pos)
+float	TerrainGenerator::noise2D(const Perlin &sampler, const NoiseSettings &settings, const mlm::vec2 &pos)
 {
 	return (settings.spline.evaluate(_octaves2D(sampler, pos / settings.zoom, static_cast<uint64_t>(settings.depth), settings.step)));
 }
 
-float	TerrainGenerator::noise3D(Perlin &sampler, const NoiseSettings &settings, const mlm::vec3 &pos)
+float	TerrainGenerator::noise3D(const Perlin &sampler, const NoiseSettings &settings, const mlm::vec3 &pos)
 {
 	return (settings.spline.evaluate(_octaves3D(sampler, pos / settings.zoom, static_cast<uint64_t>(settings.depth), settings.step)));
 }
 
-float	TerrainGenerator::_octaves2D(Perlin &sampler, const mlm::vec2 &pos, uint64_t depth, float step)
+void	TerrainGenerator::noise2D(const Perlin &sampler, const NoiseSettings &settings, const float *xs, const float *ys, float *out, size_t count)
+{
+	for (size_t start = 0; start < count; start += NOISE_BATCH_SIZE)
+	{
+		size_t	batch = std::min(count - start, NOISE_BATCH_SIZE);
+		float	zoomedX[NOISE_BATCH_SIZE];
+		float	zoomedY[NOISE_BATCH_SIZE];
+		for (size_t i = 0; i < batch; ++i)
+		{
+			zoomedX[i] = xs[start + i] / settings.zoom;
+			zoomedY[i] = ys[start + i] / settings.zoom;
+		}
+		_octaves(sampler, zoomedX, zoomedY, nullptr, out + start, batch, static_cast<uint64_t>(settings.depth), settings.step);
+		settings.spline.evaluate(out + start, out + start, batch);
+	}
+}
+
+void	TerrainGenerator::noise3D(const Perlin &sampler, const NoiseSettings &settings, const float *xs, const float *ys, const float *zs, float *out, size_t count)
+{
+	for (size_t start = 0; start < count; start += NOISE_BATCH_SIZE)
+	{
+		size_t	batch = std::min(count - start, NOISE_BATCH_SIZE);
+		float	zoomedX[NOISE_BATCH_SIZE];
+		float	zoomedY[NOISE_BATCH_SIZE];
+		float	zoomedZ[NOISE_BATCH_SIZE];
+		for (size_t i = 0; i < batch; ++i)
+		{
+			zoomedX[i] = xs[start + i] / settings.zoom;
+			zoomedY[i] = ys[start + i] / settings.zoom;
+			zoomedZ[i] = zs[start + i] / settings.zoom;
+		}
+		_octaves(sampler, zoomedX, zoomedY, zoomedZ, out + start, batch, static_cast<uint64_t>(settings.depth), settings.step);
+		settings.spline.evaluate(out + start, out + start, batch);
+	}
+}
+
+float	TerrainGenerator::_octaves2D(const Perlin &sampler, const mlm::vec2 &pos, uint64_t depth, float step)
 {
 	float	ret = 0.0f;
 	float	amplitude = 1.0f;
@@ -170,7 +420,7 @@ float	TerrainGenerator::_octaves2D(Perlin &sampler, const mlm::vec2 &pos, uint64
 	return (ret);
 }
 
-float	TerrainGenerator::_octaves3D(Perlin &sampler, const mlm::vec3 &pos, uint64_t depth, float step)
+float	TerrainGenerator::_octaves3D(const Perlin &sampler, const mlm::vec3 &pos, uint64_t depth, float step)
 {
 	float	ret = 0.0f;
 	float	amplitude = 1.0f;
@@ -188,3 +438,113 @@ float	TerrainGenerator::_octaves3D(Perlin &sampler, const mlm::vec3 &pos, uint64
 	}
 	return (ret);
 }
+
+// Batch of _octaves2D, or _octaves3D when zs isn't nullptr. count can't be more than NOISE_BATCH_SIZE.
+// Like the single versions a position stops adding octaves after the first one that is too small
+void	TerrainGenerator::_octaves(const Perlin &sampler, const float *xs, const float *ys, const float *zs, float *out, size_t count, uint64_t depth, float step)
+{
+	float	amplitude = 1.0f;
+	float	frequency = 1.0f;
+	bool	active[NOISE_BATCH_SIZE];
+	size_t	activeCount = count;
+	float	octaveX[NOISE_BATCH_SIZE];
+	float	octaveY[NOISE_BATCH_SIZE];
+	float	octaveZ[NOISE_BATCH_SIZE];
+	float	values[NOISE_BATCH_SIZE];
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i] = 0.0f;
+		active[i] = true;
+	}
+	for (; depth > 0 && activeCount > 0; --depth)
+	{
+		for (size_t i = 0; i < count; ++i)
+		{
+			octaveX[i] = xs[i] * frequency;
+			octaveY[i] = ys[i] * frequency;
+			if (zs)
+				octaveZ[i] = zs[i] * frequency;
+		}
+		if (zs)
+			sampler.getValues(octaveX, octaveY, octaveZ, values, count);
+		else
+			sampler.getValues(octaveX, octaveY, values, count);
+		for (size_t i = 0; i < count; ++i)
+		{
+			if (!active[i])
+				continue ;
+			float	temp = values[i] / amplitude;
+			if (std::abs(temp) > std::numeric_limits<float>::epsilon())
+				out[i] += temp;
+			else
+			{
+				active[i] = false;
+				activeCount--;
+			}
+		}
+		amplitude *= step;
+		frequency *= step;
+	}
+}
+
+Block::Type	TerrainGenerator::_getTerrainType(int y, int terrainHeight, bool sand) const
+{
+	if (y > terrainHeight)
+		return (Block::AIR);
+	if (y == terrainHeight)
+	{
+		if (sand)
+			return (Block::SAND);
+		return (_isUnderwater(y, terrainHeight) ? Block::DIRT : Block::GRASS);
+	}
+	if (y > terrainHeight - 4)
+		return (sand ? Block::SAND : Block::DIRT);
+	return (Block::STONE);
+}
+
+bool	TerrainGenerator::_isUnderwater(int y, int terrainHeight) const
+{
+	return (y <= _seaLevel && terrainHeight < _seaLevel);
+}
+
+void	TerrainGenerator::_compile()
+{
+	std::map<std::string, NoiseSettings>	noises = {
+		{"continentalness", _continentalness},
+		{"cave", _cave},
+		{"sand", _sand},
+	};
+	std::map<std::string, float>			constants = {
+		{"seaLevel", static_cast<float>(_seaLevel)},
+		{"caveDiameter", _caveDiameter},
+		{"sandBeachThreshold", _sandBeachThreshold},
+		{"sandSeaThreshold", _sandSeaThreshold},
+	};
+	_program = DensityProgram(_graph, noises, constants);
+	_program.setSplineResolution(_splineResolution);
+	_program.setSeed(_seed);
+}
+
+void	TerrainGenerator::_evaluateColumns(const float *xs, const float *zs, const float *const *noises, TerrainColumn *out, size_t count) const
+{
+	float	heights[DENSITY_BATCH_SIZE];
+	float	sand[DENSITY_BATCH_SIZE];
+	float	terms[DENSITY_BATCH_SIZE * DENSITY_COLUMN_TERMS] = {};
+	_program.getColumns(xs, zs, noises, heights, sand, terms, count);
+	for (size_t i = 0; i < count; ++i)
+	{
+		out[i].height = static_cast<int>(heights[i]);
+		out[i].sand = (sand[i] > 0.0f);
+		std::copy_n(&terms[i * DENSITY_COLUMN_TERMS], DENSITY_COLUMN_TERMS, out[i].terms.begin());
+	}
+}
+
+TerrainColumn	TerrainGenerator::_getColumn(const mlm::ivec2 &pos) const
+{
+	float			x = static_cast<float>(pos.x);
+	float			z = static_cast<float>(pos.y);
+	TerrainColumn	ret;
+	_evaluateColumns(&x, &z, nullptr, &ret, 1);
+	return (ret);
+}
@@ -0,0 +1,134 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "BlockPool.hpp"
+
+#include <new>
+#include <sys/mman.h>
+
+static_assert(BlockPool::SLAB_BYTES % BlockPool::ARRAY_BYTES == 0, "Slabs have to hold a whole number of arrays");
+
+std::mutex				BlockPool::_mtx;
+std::vector<void *>		BlockPool::_free;
+std::vector<uint8_t *>	BlockPool::_slabs;
+uint8_t					*BlockPool::_slabNext = nullptr;
+uint8_t					*BlockPool::_slabEnd = nullptr;
+size_t					BlockPool::_highWater = 0;
+size_t					BlockPool::_residentBytes = 0;
+bool					BlockPool::_hugePages = false;
+uint64_t				BlockPool::_hits = 0;
+uint64_t				BlockPool::_misses = 0;
+
+// Freed arrays above the new mark are only dropped once they are reused, slabs are never unmapped
+void	BlockPool::configure(size_t highWaterBytes, bool hugePages)
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	_highWater = highWaterBytes;
+	_hugePages = hugePages;
+}
+
+void	*BlockPool::allocate()
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	if (!_free.empty())
+	{
+		void	*array = _free.back();
+		_free.pop_back();
+		if (_isInSlab(array) == false)
+			_residentBytes -= ARRAY_BYTES;
+		_hits++;
+		return (array);
+	}
+	_misses++;
+	if (_hugePages)
+	{
+		void	*array = _allocateFromSlab();
+		if (array)
+			return (array);
+	}
+	return (::operator new(ARRAY_BYTES));
+}
+
+void	BlockPool::release(void *array)
+{
+	if (!array)
+		return ;
+	std::lock_guard<std::mutex>	lock(_mtx);
+	if (_isInSlab(array))
+	{
+		_free.push_back(array);
+		return ;
+	}
+	if (_residentBytes + ARRAY_BYTES > _highWater)
+	{
+		::operator delete(array);
+		return ;
+	}
+	_free.push_back(array);
+	_residentBytes += ARRAY_BYTES;
+}
+
+// Arrays in slabs stay pooled, sections that are still alive can be using the rest of their slab
+void	BlockPool::clear()
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	std::erase_if(_free, [](void *array) {
+		if (_isInSlab(array))
+			return (false);
+		::operator delete(array);
+		return (true);
+	});
+	_residentBytes = _slabs.size() * SLAB_BYTES;
+}
+
+BlockPool::Stats	BlockPool::getStats()
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	Stats						stats = {_hits, _misses, _residentBytes};
+	return (stats);
+}
+
+/*
+// Maps a new slab once the last one is used up and the high-water mark leaves room for it.
+// Explicit huge pages have to be reserved by the system, otherwise transparent ones are asked for
+*/
+void	*BlockPool::_allocateFromSlab()
+{
+	if (_slabNext == _slabEnd)
+	{
+		if (_residentBytes + SLAB_BYTES > _highWater)
+			return (nullptr);
+		void	*slab = mmap(nullptr, SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (slab == MAP_FAILED)
+		{
+			// A transparent huge page has to be aligned to its size, so twice as much is mapped and the rest cut off
+			uint8_t	*mapped = static_cast<uint8_t *>(mmap(nullptr, 2 * SLAB_BYTES, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0));
+			if (mapped == MAP_FAILED)
+				return (nullptr);
+			uint8_t	*aligned = mapped + (SLAB_BYTES - reinterpret_cast<uintptr_t>(mapped) % SLAB_BYTES) % SLAB_BYTES;
+			if (aligned > mapped)
+				munmap(mapped, aligned - mapped);
+			munmap(aligned + SLAB_BYTES, mapped + 2 * SLAB_BYTES - (aligned + SLAB_BYTES));
+			madvise(aligned, SLAB_BYTES, MADV_HUGEPAGE);
+			slab = aligned;
+		}
+		_slabs.push_back(static_cast<uint8_t *>(slab));
+		_slabNext = static_cast<uint8_t *>(slab);
+		_slabEnd = _slabNext + SLAB_BYTES;
+		_residentBytes += SLAB_BYTES;
+	}
+	void	*array = _slabNext;
+	_slabNext += ARRAY_BYTES;
+	return (array);
+}
+
+bool	BlockPool::_isInSlab(const void *array)
+{
+	const uint8_t	*bytes = static_cast<const uint8_t *>(array);
+	for (const uint8_t *slab : _slabs)
+		if (bytes >= slab && bytes < slab + SLAB_BYTES)
+			return (true);
+	return (false);
+}
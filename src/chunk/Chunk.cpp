@@ -16,11 +16,23 @@ int	getChunkCount()
 	return (chunk_count);
 }
 
-Chunk::Chunk(ChunkManager &manager): _manager(manager)
+// Every chunk starts out as this snapshot, all air
+static ChunkSnapshotPtr	emptySnapshot()
 {
+	static const ChunkSnapshotPtr	empty = [](){
+		std::shared_ptr<ChunkSnapshot>	snapshot = std::make_shared<ChunkSnapshot>();
+		std::shared_ptr<ChunkSection>	air = std::make_shared<ChunkSection>();
+		snapshot->sections.fill(air);
+		return (snapshot);
+	}();
+	return (empty);
 }
 
-Chunk::Chunk(const mlm::ivec2 &chunkPos, ChunkManager &manager): _chunkPos(chunkPos), _manager(manager)
+Chunk::Chunk(ChunkManager &manager): _snapshot(emptySnapshot()), _manager(manager)
+{
+}
+
+Chunk::Chunk(const mlm::ivec2 &chunkPos, ChunkManager &manager): _snapshot(emptySnapshot()), _chunkPos(chunkPos), _manager(manager)
 {
 	_worldPos = mlm::ivec3(CHUNK_SIZE_X * _chunkPos.x, 0, CHUNK_SIZE_Z * _chunkPos.y);
 	setState(LOADED);
@@ -39,6 +51,26 @@ Chunk::~Chunk()
 	chunk_count--;
 }
 
+void	Chunk::reset(const mlm::ivec2 &chunkPos)
+{
+	// The pool already freed the GPU buffers
+	_busyMtx.lock();
+	_mesh.clear_vertices();
+	_waterMesh.clear_vertices();
+	_blockMtx.lock();
+	_snapshot.store(emptySnapshot());
+	_blockMtx.unlock();
+	_chunkPos = chunkPos;
+	_worldPos = mlm::ivec3(CHUNK_SIZE_X * _chunkPos.x, 0, CHUNK_SIZE_Z * _chunkPos.y);
+	_min = INFINITY;
+	_max = -INFINITY;
+	_busy = false;
+	_dirty = false;
+	_readyToUpload = false;
+	_savedVersion = 0;
+	setState(LOADED);
+	_busyMtx.unlock();
+}
 
 void	Chunk::draw(Shader &shader)
 {
@@ -67,7 +99,53 @@ void	Chunk::upload()
 	_busyMtx.lock();
 	_mesh.setup_mesh();
 	_waterMesh.setup_mesh();
+	if (_manager.getFreeMeshVertices())
+	{
+		_mesh.free_vertices();
+		_waterMesh.free_vertices();
+	}
 	_busyMtx.unlock();
 	_readyToUpload = false;
 	setState(UPLOADED);
 }
+
+void	Chunk::releaseMesh()
+{
+	_busyMtx.lock();
+	if (getState() == UPLOADED)
+	{
+		_mesh.del();
+		_waterMesh.del();
+		if (_mesh.has_vertices() && _waterMesh.has_vertices())
+		{
+			setState(MESHED);
+			_readyToUpload = true;
+		}
+		else
+			setState(GENERATED);
+	}
+	_busyMtx.unlock();
+}
+
+void	Chunk::releaseBlocks()
+{
+	_blockMtx.lock();
+	_snapshot.store(emptySnapshot());
+	_blockMtx.unlock();
+}
+
+void	Chunk::releaseGpu()
+{
+	_busyMtx.lock();
+	if (getState() == UPLOADED || getState() == DIRTY)
+	{
+		_mesh.del();
+		_waterMesh.del();
+	}
+	// Buffers shared with the mesh cache are let go, the pool only keeps the ones the chunk owns
+	_mesh.clear_vertices();
+	_waterMesh.clear_vertices();
+	_readyToUpload = false;
+	setState(UNLOADED);
+	_busyMtx.unlock();
+}
@@ -4,30 +4,69 @@ Created on: 23/03/2026
 */
 
 #include "Chunk.hpp"
+#include "ChunkManager.hpp"
 #include "Coords.hpp"
 
+#include <algorithm>
+
 void	Chunk::generate(TerrainGeneratorPtr generator)
 {
 	_busyMtx.lock();
 
-	perlinSamplers samplers = generator->getSamplers();
+	std::array<TerrainColumn, CHUNK_SIZE_X * CHUNK_SIZE_Z>	columns;
+	// Everything above the highest column and the sea is air, so those sections stay uniform
+	int														maxHeight = generator->getSeaLevel();
+	generator->getColumns(mlm::ivec2(_worldPos.x, _worldPos.z), mlm::ivec2(CHUNK_SIZE_X, CHUNK_SIZE_Z), columns.data());
+	for (const TerrainColumn &column : columns)
+		maxHeight = std::max(maxHeight, column.height);
+	// Caves are only in solid blocks, so nothing above the highest column
+	CaveLattice	caves = generator->getCaveLattice(_worldPos, mlm::ivec3(CHUNK_SIZE_X, maxHeight + 1, CHUNK_SIZE_Z));
 
-	for (uint64_t x = 0; x < CHUNK_SIZE_X; ++x)
+	std::shared_ptr<ChunkSnapshot>	snapshot = std::make_shared<ChunkSnapshot>();
+	for (uint64_t sectionY = 0; sectionY < CHUNK_SECTION_COUNT; ++sectionY)
 	{
-		for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+		uint64_t						baseY = sectionY * SECTION_SIZE;
+		std::shared_ptr<ChunkSection>	section = std::make_shared<ChunkSection>();
+		if (static_cast<int>(baseY) <= maxHeight)
 		{
-			int	terrainHeight = generator->getTerrainHeight(samplers, mlm::ivec2(x + _worldPos.x, z + _worldPos.z));
-			for (uint64_t y = 0; y < CHUNK_SIZE_Y; ++y)
+			for (uint64_t x = 0; x < CHUNK_SIZE_X; ++x)
 			{
-				mlm::ivec3	pos = _worldPos + mlm::ivec3(x, y, z);
-				uint64_t	index = index3D(x, y, z);
-				Block		block = generator->getBlock(samplers, pos, terrainHeight);
-				_blockMtx.lock();
-				_blocks[index] = block;
-				_blockMtx.unlock();
+				for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+				{
+					std::array<Block, SECTION_SIZE>	blocks;
+					generator->getBlocks(columns[z * CHUNK_SIZE_X + x], caves, _worldPos + mlm::ivec3(x, baseY, z), blocks.data(), blocks.size());
+					section->setColumn(x, z, blocks.data());
+				}
 			}
+			section->compact();
 		}
+		snapshot->sections[sectionY] = std::move(section);
 	}
+	// Blocks the player changed are set before publishing, so the unedited terrain is never meshed.
+	// setBlock records its edit while holding _blockMtx, so an edit is either in the journal already or lands on this snapshot
+	_blockMtx.lock();
+	_manager.getEditJournal().apply(_chunkPos, *snapshot);
+	// Publish all sections at once, meshing neighbors never see a half generated chunk
+	snapshot->version = getSnapshot()->version + 1;
+	_snapshot.store(std::move(snapshot));
+	_blockMtx.unlock();
+	setState(GENERATED);
+	_busyMtx.unlock();
+	_busy = false;
+}
+
+void	Chunk::load(ChunkSnapshotPtr snapshot)
+{
+	_busyMtx.lock();
+	std::shared_ptr<ChunkSnapshot>	loaded = std::make_shared<ChunkSnapshot>(*snapshot);
+	// The journal can have edits that were made after the chunk was saved, applied under _blockMtx like in generate
+	_blockMtx.lock();
+	bool							edited = _manager.getEditJournal().apply(_chunkPos, *loaded);
+	loaded->version = getSnapshot()->version + 1;
+	if (edited == false)
+		_savedVersion = loaded->version;
+	_snapshot.store(std::move(loaded));
+	_blockMtx.unlock();
 	setState(GENERATED);
 	_busyMtx.unlock();
 	_busy = false;
@@ -7,6 +7,10 @@ Created on: 23/03/2026
 #include "VoxEngine.hpp"
 #include "Coords.hpp"
 
+#include <algorithm>
+#include <bit>
+#include <chrono>
+
 enum Faces {
 	TOP,
 	BACK,
@@ -27,33 +31,175 @@ enum Corners {
 	FRONT_TOP_RIGHT,
 };
 
-enum UvCorners {
-	BOTTOM_LEFT,
-	BOTTOM_RIGHT,
-	TOP_LEFT,
-	TOP_RIGHT,
+// Corner offsets of a unit cube, indexed by Corners
+static const mlm::ivec3	cornerOffsets[] = {
+	mlm::ivec3(0, 0, 0),
+	mlm::ivec3(1, 0, 0),
+	mlm::ivec3(0, 1, 0),
+	mlm::ivec3(1, 1, 0),
+	mlm::ivec3(0, 0, 1),
+	mlm::ivec3(1, 0, 1),
+	mlm::ivec3(0, 1, 1),
+	mlm::ivec3(1, 1, 1),
+};
+
+// Quad corners of each face in counter clockwise order, drawn as triangles (0, 1, 2) and (0, 2, 3)
+static const Corners	faceCorners[6][4] = {
+	{BACK_TOP_LEFT, FRONT_TOP_LEFT, FRONT_TOP_RIGHT, BACK_TOP_RIGHT},
+	{BACK_BOTTOM_RIGHT, BACK_BOTTOM_LEFT, BACK_TOP_LEFT, BACK_TOP_RIGHT},
+	{FRONT_BOTTOM_RIGHT, FRONT_TOP_RIGHT, FRONT_TOP_LEFT, FRONT_BOTTOM_LEFT},
+	{BACK_BOTTOM_LEFT, FRONT_BOTTOM_LEFT, FRONT_TOP_LEFT, BACK_TOP_LEFT},
+	{BACK_BOTTOM_RIGHT, BACK_TOP_RIGHT, FRONT_TOP_RIGHT, FRONT_BOTTOM_RIGHT},
+	{BACK_BOTTOM_RIGHT, FRONT_BOTTOM_RIGHT, FRONT_BOTTOM_LEFT, BACK_BOTTOM_LEFT},
+};
+
+// Axis the face points along, followed by the 2 axes the face spans (x = 0, y = 1, z = 2)
+struct FaceAxes {
+	int	normal;
+	int	u;
+	int	v;
+};
+
+static const FaceAxes	faceAxes[] = {
+	{1, 0, 2},
+	{2, 0, 1},
+	{2, 0, 1},
+	{0, 2, 1},
+	{0, 2, 1},
+	{1, 0, 2},
 };
 
-static bool		shouldDrawFace(Expected<Block, int> &neighborResult, Block &block)
+static const mlm::ivec3	chunkSize(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z);
+
+// Padded volume of block types: the chunk with a 1 block border on every side
+constexpr int64_t	PADDED_X = CHUNK_SIZE_X + 2;
+constexpr int64_t	PADDED_Y = CHUNK_SIZE_Y + 2;
+constexpr int64_t	PADDED_Z = CHUNK_SIZE_Z + 2;
+constexpr int64_t	PADDED_VOLUME = PADDED_X * PADDED_Y * PADDED_Z;
+
+// Cell values past the block types, used for the border cells that aren't blocks of a loaded chunk
+enum Sentinels : uint8_t {
+	OUTSIDE_WORLD = Block::TYPE_COUNT, // Above or below the world, faces against it are drawn
+	UNLOADED, // Part of a chunk that isn't loaded, faces against it are hidden
+	CELL_COUNT,
+};
+
+// Same order as index3D, x changes fastest. Coordinates go from -1 up to and including the chunk size
+static int64_t	paddedIndex(int64_t x, int64_t y, int64_t z)
 {
-	if (!neighborResult.hasValue())
+	return (((z + 1) * PADDED_Y + (y + 1)) * PADDED_X + (x + 1));
+}
+
+// Offset to the neighboring cell of each face in the padded volume, indexed by Faces
+static const int64_t	paddedNeighbors[] = {
+	PADDED_X,
+	-PADDED_X * PADDED_Y,
+	PADDED_X * PADDED_Y,
+	-1,
+	1,
+	-PADDED_X,
+};
+
+/*
+// drawFace[type][neighbor] is 1 if a block of type has a visible face against the neighbor cell.
+// Disabled blocks never have visible faces, so air needs no separate check
+*/
+using FaceTable = std::array<std::array<uint8_t, CELL_COUNT>, Block::TYPE_COUNT>;
+
+static FaceTable	buildFaceTable()
+{
+	FaceTable	table = {};
+	for (uint8_t type = 0; type < Block::TYPE_COUNT; ++type)
 	{
-		if (neighborResult.error() == 1)
-			return (true);
-		return (false);
+		Block	block(static_cast<Block::Type>(type));
+		if (!block.getEnabled())
+			continue ;
+		for (uint8_t cell = 0; cell < Block::TYPE_COUNT; ++cell)
+		{
+			Block	neighbor(static_cast<Block::Type>(cell));
+			if (block.getType() == Block::WATER && neighbor.getType() == Block::AIR)
+				table[type][cell] = 1;
+			if (block.getTransparent() == false && neighbor.getTransparent() == true)
+				table[type][cell] = 1;
+		}
+		table[type][OUTSIDE_WORLD] = 1;
+		table[type][UNLOADED] = 0;
+	}
+	return (table);
+}
+
+static const FaceTable	drawFace = buildFaceTable();
+
+/*
+// Buffers a worker meshes in. They keep their capacity from one mesh to the next, so once they
+// have grown to the largest mesh seen meshing doesn't allocate anymore.
+// Except for the vertex buffers, they are handed to the mesh they were built for and take the old buffers of that mesh in their place
+*/
+struct MeshScratch {
+	std::vector<uint8_t>		volume;
+	std::vector<uint8_t>		visibleFaces;
+	std::vector<Block::Type>	types;
+	std::vector<Block::Type>	mask;
+	std::vector<ChunkVertex>	vertices;
+	std::vector<ChunkVertex>	waterVertices;
+};
+
+static thread_local MeshScratch	meshScratch;
+
+// Scratch vertex buffers larger than this are freed instead of kept, so one large mesh doesn't pin its buffer on every worker
+constexpr size_t	MAX_SCRATCH_VERTICES = 1 << 16;
+
+// Readies the buffer a mesh gave back to build the next mesh in. One that's too small,
+// like the empty one of a mesh that was shared with the cache, is reserved to the size of the last mesh
+static void	recycleScratch(std::vector<ChunkVertex> &vertices, size_t lastSize)
+{
+	if (vertices.capacity() > MAX_SCRATCH_VERTICES)
+		std::vector<ChunkVertex>().swap(vertices);
+	vertices.clear();
+	vertices.reserve(std::min(lastSize, MAX_SCRATCH_VERTICES));
+}
+
+// Copies the block types of the chunk and the bordering blocks of its neighbors into volume
+static void	gatherPaddedVolume(const ChunkNeighborhood &area, std::vector<uint8_t> &volume)
+{
+	volume.assign(PADDED_VOLUME, UNLOADED);
+	for (int64_t z = -1; z <= static_cast<int64_t>(CHUNK_SIZE_Z); ++z)
+	{
+		std::fill_n(&volume[paddedIndex(-1, -1, z)], PADDED_X, OUTSIDE_WORLD);
+		std::fill_n(&volume[paddedIndex(-1, CHUNK_SIZE_Y, z)], PADDED_X, OUTSIDE_WORLD);
+	}
+
+	for (uint64_t sectionY = 0; sectionY < CHUNK_SECTION_COUNT; ++sectionY)
+	{
+		const ChunkSection	&section = *area.center->sections[sectionY];
+		for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+			for (uint64_t y = 0; y < SECTION_SIZE; ++y)
+				section.copyRowTypes(y, z, &volume[paddedIndex(0, sectionY * SECTION_SIZE + y, z)]);
+	}
+
+	for (int64_t y = 0; y < static_cast<int64_t>(CHUNK_SIZE_Y); ++y)
+	{
+		for (int64_t i = 0; i < static_cast<int64_t>(CHUNK_SIZE_Z); ++i)
+		{
+			if (area.west)
+				volume[paddedIndex(-1, y, i)] = area.west->getBlock(CHUNK_SIZE_X - 1, y, i).getType();
+			if (area.east)
+				volume[paddedIndex(CHUNK_SIZE_X, y, i)] = area.east->getBlock(0, y, i).getType();
+		}
+		for (int64_t i = 0; i < static_cast<int64_t>(CHUNK_SIZE_X); ++i)
+		{
+			if (area.north)
+				volume[paddedIndex(i, y, -1)] = area.north->getBlock(i, y, CHUNK_SIZE_Z - 1).getType();
+			if (area.south)
+				volume[paddedIndex(i, y, CHUNK_SIZE_Z)] = area.south->getBlock(i, y, 0).getType();
+		}
 	}
-	Block neighbor = neighborResult.value();
-	if (block.getType() == Block::WATER && neighbor.getType() == Block::AIR)
-		return (true);
-	if (block.getTransparent() == false && neighbor.getTransparent() == true)
-		return (true);
-	return (false);
 }
 
 // Added vertex to vertices while keeping track of the min and max values found so far
-void	Chunk::_pushBackVertexWrapper(std::vector<Vertex> &vertices, const Vertex &vert)
+void	Chunk::_pushBackVertexWrapper(std::vector<ChunkVertex> &vertices, const mlm::ivec3 &pos, int face, Block::Type type)
 {
-	const mlm::vec3 &vec = vert.pos;
+	const mlm::vec3 vec(pos);
 	_min.x = std::min(_min.x, vec.x);
 	_min.y = std::min(_min.y, vec.y);
 	_min.z = std::min(_min.z, vec.z);
@@ -61,160 +207,240 @@ void	Chunk::_pushBackVertexWrapper(std::vector<Vertex> &vertices, const Vertex &
 	_max.x = std::max(_max.x, vec.x);
 	_max.y = std::max(_max.y, vec.y);
 	_max.z = std::max(_max.z, vec.z);
-	vertices.push_back(vert);
+	vertices.push_back(packChunkVertex(pos.x, pos.y, pos.z, face, type));
 }
 
-void	Chunk::_addCube(std::vector<Vertex> &vertices, const mlm::ivec3 &ipos)
+// Adds a quad covering size blocks starting at ipos, size is 1 along the axis the face points to
+void	Chunk::_addQuad(std::vector<ChunkVertex> &vertices, int face, const mlm::ivec3 &ipos, const mlm::ivec3 &size, Block::Type type)
 {
-	static const mlm::ivec3	neighbors[] = {
-		mlm::ivec3(0, 1, 0),
-		mlm::ivec3(0, 0, -1),
-		mlm::ivec3(0, 0, 1),
-		mlm::ivec3(-1, 0, 0),
-		mlm::ivec3(1, 0, 0),
-		mlm::ivec3(0, -1, 0),
-	};
+	mlm::ivec3	corners[4];
+	for (int i = 0; i < 4; ++i)
+		corners[i] = ipos + cornerOffsets[faceCorners[face][i]] * size;
 
-	static const mlm::vec3	normals[] = {
-		mlm::vec3(0.0f, 1.0f, 0.0f),
-		mlm::vec3(0.0f, 0.0f, -1.0f),
-		mlm::vec3(0.0f, 0.0f, 1.0f),
-		mlm::vec3(-1.0f, 0.0f, 0.0f),
-		mlm::vec3(1.0f, 0.0f, 0.0f),
-		mlm::vec3(0.0f, -1.0f, 0.0f),
-	};
+	_pushBackVertexWrapper(vertices, corners[0], face, type);
+	_pushBackVertexWrapper(vertices, corners[1], face, type);
+	_pushBackVertexWrapper(vertices, corners[2], face, type);
+	_pushBackVertexWrapper(vertices, corners[3], face, type);
+}
 
-	mlm::ivec3	worldPos = _worldPos + ipos;
-	mlm::vec3	pos(ipos);
-	const mlm::vec3	positions[] = {
-		mlm::vec3(0.0f, 0.0f, 0.0f) + pos, // 0 back bottom left
-		mlm::vec3(1.0f, 0.0f, 0.0f) + pos, //  1 back bottom right
-		mlm::vec3(0.0f, 1.0f, 0.0f) + pos, //  2 back top left
-		mlm::vec3(1.0f, 1.0f, 0.0f) + pos, //   3 back top right
-		mlm::vec3(0.0f, 0.0f, 1.0f) + pos, //  4 front bottom left
-		mlm::vec3(1.0f, 0.0f, 1.0f) + pos, //   5 front bottom right
-		mlm::vec3(0.0f, 1.0f, 1.0f) + pos, //   6 front top left
-		mlm::vec3(1.0f, 1.0f, 1.0f) + pos, //    7 front top right
-	};
-	Block		block = getBlock(ipos);
-	Atlas		&atlas = _manager.getEngine().getAtlas();
-	const std::vector<mlm::vec2>	&offsets = atlas.getOffset(block.getType());
-	const std::vector<mlm::vec2>	&uvCorners = atlas.getCorners();
+void	Chunk::_addCube(std::vector<ChunkVertex> &vertices, const mlm::ivec3 &ipos, Block::Type type, uint8_t faces)
+{
+	for (int face = TOP; face <= BOTTOM; ++face)
+		if (faces & (1 << face))
+			_addQuad(vertices, face, ipos, mlm::ivec3(1), type);
+}
 
-	std::vector<Expected<Block, int>> blockNeighbors;
-	for (const mlm::ivec3 &neighbor : neighbors)
-	{
-		mlm::ivec3	neighborIpos = ipos + neighbor;
-		// Check wether neighbor is within chunk or not
-		if (
-			neighborIpos.x < 0 || neighborIpos.x >= static_cast<int>(CHUNK_SIZE_X) ||
-			neighborIpos.y < 0 || neighborIpos.y >= static_cast<int>(CHUNK_SIZE_Y) ||
-			neighborIpos.z < 0 || neighborIpos.z >= static_cast<int>(CHUNK_SIZE_Z)
-		)
-			blockNeighbors.push_back(_manager.getBlock(worldPos + neighbor));
-		else
-			blockNeighbors.push_back(getBlock(neighborIpos));
-	}
+/*
+// Finds the visible faces of every block, returns the amount of visible faces.
+// Uniform sections are skipped: air has no faces, and inside any other uniform section every
+// neighbor has the same type, so only the blocks on the outside of the section are checked
+*/
+uint64_t	Chunk::_findVisibleFaces(const ChunkNeighborhood &area, MeshScratch &scratch)
+{
+	constexpr uint64_t			chunkVolume = CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z;
+	const std::vector<uint8_t>	&volume = scratch.volume;
+	std::vector<uint8_t>		&visibleFaces = scratch.visibleFaces;
+	std::vector<Block::Type>	&types = scratch.types;
+	gatherPaddedVolume(area, scratch.volume);
+	visibleFaces.assign(chunkVolume, 0);
+	types.assign(chunkVolume, Block::AIR);
 
-	// top face
-	if (shouldDrawFace(blockNeighbors[TOP], block) == true)
-	{
-		mlm::vec3	normal = normals[TOP] * 0.9f;
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_LEFT],		normal, offsets[TOP] + uvCorners[TOP_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_LEFT],		normal, offsets[TOP] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_RIGHT],	normal, offsets[TOP] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_LEFT],		normal, offsets[TOP] + uvCorners[TOP_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_RIGHT],	normal, offsets[TOP] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_RIGHT],		normal, offsets[TOP] + uvCorners[TOP_RIGHT]});
-	}
-	// back face
-	if (shouldDrawFace(blockNeighbors[BACK], block) == true)
-	{
-		mlm::vec3	normal = normals[BACK] * 0.7f;
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_LEFT],	normal, offsets[BACK] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_LEFT],		normal, offsets[BACK] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_RIGHT],	normal, offsets[BACK] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_RIGHT],	normal, offsets[BACK] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_LEFT],		normal, offsets[BACK] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_RIGHT],		normal, offsets[BACK] + uvCorners[TOP_LEFT]});
-	}
-	// front face
-	if (shouldDrawFace(blockNeighbors[FRONT], block) == true)
-	{
-		mlm::vec3	normal = normals[FRONT] * 0.7f;
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_LEFT],	normal, offsets[FRONT] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_RIGHT],	normal, offsets[FRONT] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_LEFT],		normal, offsets[FRONT] + uvCorners[TOP_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_RIGHT],	normal, offsets[FRONT] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_RIGHT],	normal, offsets[FRONT] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_LEFT],		normal, offsets[FRONT] + uvCorners[TOP_LEFT]});
-	}
-	// left face
-	if (shouldDrawFace(blockNeighbors[LEFT], block) == true)
+	uint64_t	faceCount = 0;
+	for (uint64_t sectionY = 0; sectionY < CHUNK_SECTION_COUNT; ++sectionY)
 	{
-		mlm::vec3	normal = normals[LEFT] * 0.8f;
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_LEFT],	normal, offsets[LEFT] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_LEFT],	normal, offsets[LEFT] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_LEFT],		normal, offsets[LEFT] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_LEFT],	normal, offsets[LEFT] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_LEFT],		normal, offsets[LEFT] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_LEFT],		normal, offsets[LEFT] + uvCorners[TOP_LEFT]});
-	}
-	// right face
-	if (shouldDrawFace(blockNeighbors[RIGHT], block) == true)
-	{
-		mlm::vec3	normal = normals[RIGHT] * 0.8f;
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_RIGHT],	normal, offsets[RIGHT] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_RIGHT],	normal, offsets[RIGHT] + uvCorners[TOP_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_RIGHT],	normal, offsets[RIGHT] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_RIGHT],	normal, offsets[RIGHT] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_TOP_RIGHT],		normal, offsets[RIGHT] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_TOP_RIGHT],	normal, offsets[RIGHT] + uvCorners[TOP_LEFT]});
-	}
-	// bottom face
-	if (shouldDrawFace(blockNeighbors[BOTTOM], block) == true)
-	{
-		mlm::vec3	normal = normals[BOTTOM] * 0.9f;
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_RIGHT],	normal, offsets[BOTTOM] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_LEFT],	normal, offsets[BOTTOM] + uvCorners[TOP_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_LEFT],	normal, offsets[BOTTOM] + uvCorners[BOTTOM_LEFT]});
-		_pushBackVertexWrapper(vertices, {positions[BACK_BOTTOM_RIGHT],	normal, offsets[BOTTOM] + uvCorners[BOTTOM_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_RIGHT],	normal, offsets[BOTTOM] + uvCorners[TOP_RIGHT]});
-		_pushBackVertexWrapper(vertices, {positions[FRONT_BOTTOM_LEFT],	normal, offsets[BOTTOM] + uvCorners[TOP_LEFT]});
+		const ChunkSection	&section = *area.center->sections[sectionY];
+		bool				uniform = section.isUniform();
+		if (uniform && !section.getUniformBlock().getEnabled())
+			continue ;
+		for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+		{
+			for (uint64_t y = sectionY * SECTION_SIZE; y < (sectionY + 1) * SECTION_SIZE; ++y)
+			{
+				bool	shellOnly = uniform && z != 0 && z != CHUNK_SIZE_Z - 1 && y % SECTION_SIZE != 0 && y % SECTION_SIZE != SECTION_SIZE - 1;
+				for (uint64_t x = 0; x < CHUNK_SIZE_X; x += (shellOnly && x == 0) ? CHUNK_SIZE_X - 1 : 1)
+				{
+					const uint8_t	*cell = &volume[paddedIndex(x, y, z)];
+					const uint8_t	*faces = drawFace[*cell].data();
+					uint8_t			visible = 0;
+					for (int face = TOP; face <= BOTTOM; ++face)
+						visible |= faces[cell[paddedNeighbors[face]]] << face;
+					uint64_t		index = index3D(x, y, z);
+					visibleFaces[index] = visible;
+					types[index] = static_cast<Block::Type>(*cell);
+					faceCount += std::popcount(visible);
+				}
+			}
+		}
 	}
+	return (faceCount);
 }
 
-void	Chunk::mesh()
+// Adds one quad for every visible face of every block, returns the amount of visible faces
+uint64_t	Chunk::_meshNaive(const ChunkNeighborhood &area, MeshScratch &scratch)
 {
-	_busyMtx.lock();
-	std::vector<Vertex> vertices;
-	std::vector<Vertex> waterVertices;
+	uint64_t						faceCount = _findVisibleFaces(area, scratch);
+	const std::vector<uint8_t>		&visibleFaces = scratch.visibleFaces;
+	const std::vector<Block::Type>	&types = scratch.types;
+
 	for (uint64_t x = 0; x < CHUNK_SIZE_X; ++x)
 	{
 		for (uint64_t y = 0; y < CHUNK_SIZE_Y; ++y)
 		{
 			for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
 			{
-				uint64_t	index = index3D(x, y, z);
 				mlm::ivec3	pos(x, y, z);
-				_blockMtx.lock();
-				Block		&block = _blocks[index];
-				_blockMtx.unlock();
-				if (block.getEnabled())
+				uint64_t	index = index3D(pos);
+				if (visibleFaces[index] == 0)
+					continue ;
+				_addCube(types[index] == Block::WATER ? scratch.waterVertices : scratch.vertices, pos, types[index], visibleFaces[index]);
+			}
+		}
+	}
+	return (faceCount);
+}
+
+/*
+// Merges neighboring faces with the same block type and direction into rectangles,
+// one slice of the chunk at a time. Returns the amount of visible faces before merging
+*/
+uint64_t	Chunk::_meshGreedy(const ChunkNeighborhood &area, MeshScratch &scratch)
+{
+	uint64_t						faceCount = _findVisibleFaces(area, scratch);
+	const std::vector<uint8_t>		&visibleFaces = scratch.visibleFaces;
+	const std::vector<Block::Type>	&types = scratch.types;
+
+	std::vector<Block::Type>		&mask = scratch.mask;
+	mask.resize(CHUNK_SIZE_Y * std::max(CHUNK_SIZE_X, CHUNK_SIZE_Z));
+	for (int face = TOP; face <= BOTTOM; ++face)
+	{
+		const FaceAxes	&axes = faceAxes[face];
+		const int		sizeU = chunkSize[axes.u];
+		const int		sizeV = chunkSize[axes.v];
+		for (int n = 0; n < chunkSize[axes.normal]; ++n)
+		{
+			// Build a 2D mask of the visible faces in this slice
+			mlm::ivec3	pos(0);
+			pos[axes.normal] = n;
+			for (int v = 0; v < sizeV; ++v)
+			{
+				pos[axes.v] = v;
+				for (int u = 0; u < sizeU; ++u)
+				{
+					pos[axes.u] = u;
+					uint64_t	index = index3D(pos);
+					mask[v * sizeU + u] = (visibleFaces[index] & (1 << face)) ? types[index] : Block::AIR;
+				}
+			}
+
+			// Grow each face as wide as possible along u, then as high as possible along v
+			for (int v = 0; v < sizeV; ++v)
+			{
+				for (int u = 0; u < sizeU;)
 				{
-					if (block.getType() == Block::WATER)
-						_addCube(waterVertices, pos);
-					else
-						_addCube(vertices, pos);
+					Block::Type	type = mask[v * sizeU + u];
+					if (type == Block::AIR)
+					{
+						++u;
+						continue ;
+					}
+					int	width = 1;
+					while (u + width < sizeU && mask[v * sizeU + u + width] == type)
+						++width;
+					int	height = 1;
+					for (; v + height < sizeV; ++height)
+					{
+						Block::Type	*row = &mask[(v + height) * sizeU + u];
+						if (std::any_of(row, row + width, [type](Block::Type other) {return (other != type);}))
+							break ;
+					}
+					// Clear the merged faces from the mask
+					for (int dv = 0; dv < height; ++dv)
+						std::fill_n(&mask[(v + dv) * sizeU + u], width, Block::AIR);
+
+					mlm::ivec3	quadPos(0);
+					quadPos[axes.normal] = n;
+					quadPos[axes.u] = u;
+					quadPos[axes.v] = v;
+					mlm::ivec3	quadSize(1);
+					quadSize[axes.u] = width;
+					quadSize[axes.v] = height;
+					_addQuad(type == Block::WATER ? scratch.waterVertices : scratch.vertices, face, quadPos, quadSize, type);
+					u += width;
 				}
 			}
 		}
 	}
-	_mesh.get_vertices() = vertices;
-	_waterMesh.get_vertices() = waterVertices;
+	return (faceCount);
+}
+
+void	Chunk::mesh()
+{
+	// Cleared before taking the snapshots, so an edit made while meshing marks the chunk dirty again
+	_dirty = false;
+	ChunkNeighborhood	area = {
+		getSnapshot(),
+		_manager.getChunkSnapshot(_chunkPos + mlm::ivec2(-1, 0)),
+		_manager.getChunkSnapshot(_chunkPos + mlm::ivec2(1, 0)),
+		_manager.getChunkSnapshot(_chunkPos + mlm::ivec2(0, -1)),
+		_manager.getChunkSnapshot(_chunkPos + mlm::ivec2(0, 1)),
+	};
+	mesh(area);
+}
+
+void	Chunk::mesh(const ChunkNeighborhood &area)
+{
+	MeshScratch			&scratch = meshScratch;
+	_busyMtx.lock();
+	MeshCache			&cache = _manager.getMeshCache();
+	bool				greedy = _manager.getGreedyMeshing();
+	bool				cached = cache.isEnabled();
+	MeshCache::Key		key = cached ? MeshCache::hash(area, greedy) : MeshCache::Key{0, 0};
+	MeshCache::EntryPtr	entry = cached ? cache.find(key) : nullptr;
+	if (entry)
+	{
+		_mesh.set_vertices(entry->vertices);
+		_waterMesh.set_vertices(entry->waterVertices);
+		_min = mlm::vec3(std::min(_min.x, entry->min.x), std::min(_min.y, entry->min.y), std::min(_min.z, entry->min.z));
+		_max = mlm::vec3(std::max(_max.x, entry->max.x), std::max(_max.y, entry->max.y), std::max(_max.z, entry->max.z));
+	}
+	else
+	{
+		uint64_t							faceCount;
+		// The bounds of only this mesh go in the cache, the chunk keeps growing its own
+		mlm::vec3							min = _min;
+		mlm::vec3							max = _max;
+		_min = INFINITY;
+		_max = -INFINITY;
+		scratch.vertices.clear();
+		scratch.waterVertices.clear();
+		auto								start = std::chrono::steady_clock::now();
+		if (greedy)
+			faceCount = _meshGreedy(area, scratch);
+		else
+			faceCount = _meshNaive(area, scratch);
+		auto								duration = std::chrono::steady_clock::now() - start;
+		uint64_t							microseconds = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+		_manager.addMeshStats(faceCount, (scratch.vertices.size() + scratch.waterVertices.size()) / 4, microseconds);
+		_mesh.swap_vertices(scratch.vertices);
+		_waterMesh.swap_vertices(scratch.waterVertices);
+		recycleScratch(scratch.vertices, _mesh.get_vertices().size());
+		recycleScratch(scratch.waterVertices, _waterMesh.get_vertices().size());
+		// The cache shares the buffers of the meshes instead of copying them
+		if (cached)
+		{
+			std::shared_ptr<MeshCache::Entry>	built = std::make_shared<MeshCache::Entry>();
+			built->vertices = _mesh.share_vertices();
+			built->waterVertices = _waterMesh.share_vertices();
+			built->min = _min;
+			built->max = _max;
+			built->microseconds = microseconds;
+			cache.insert(key, std::move(built));
+		}
+		_min = mlm::vec3(std::min(_min.x, min.x), std::min(_min.y, min.y), std::min(_min.z, min.z));
+		_max = mlm::vec3(std::max(_max.x, max.x), std::max(_max.y, max.y), std::max(_max.z, max.z));
+	}
 	if (getState() < MESHED)
 		setState(MESHED);
-	_dirty = false;
 	_readyToUpload = true;
 	_busyMtx.unlock();
 	_busy = false;
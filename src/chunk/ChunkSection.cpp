@@ -0,0 +1,132 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "ChunkSection.hpp"
+#include "BlockPool.hpp"
+
+#include <algorithm>
+#include <new>
+#include <type_traits>
+
+ChunkSection::ChunkSection(): _uniform(Block::AIR)
+{}
+
+ChunkSection::ChunkSection(Block block): _uniform(block)
+{}
+
+ChunkSection::ChunkSection(const ChunkSection &src): _uniform(src._uniform)
+{
+	if (src._blocks)
+		_blocks.reset(_newBlocks(*src._blocks));
+}
+
+ChunkSection::~ChunkSection()
+{}
+
+ChunkSection	&ChunkSection::operator=(const ChunkSection &src)
+{
+	if (this == &src)
+		return (*this);
+	_uniform = src._uniform;
+	_blocks.reset();
+	if (src._blocks)
+		_blocks.reset(_newBlocks(*src._blocks));
+	return (*this);
+}
+
+void	ChunkSection::BlocksDeleter::operator()(Blocks *blocks) const
+{
+	static_assert(std::is_trivially_destructible_v<Blocks>, "Pooled block arrays aren't destroyed");
+	BlockPool::release(blocks);
+}
+
+ChunkSection::Blocks	*ChunkSection::_newBlocks(Block block)
+{
+	Blocks	*blocks = new (BlockPool::allocate()) Blocks;
+	blocks->fill(block);
+	return (blocks);
+}
+
+ChunkSection::Blocks	*ChunkSection::_newBlocks(const Blocks &src)
+{
+	return (new (BlockPool::allocate()) Blocks(src));
+}
+
+// Same order as index3D, x changes fastest
+uint64_t	ChunkSection::_index(uint64_t x, uint64_t y, uint64_t z)
+{
+	return (z * (SECTION_SIZE * SECTION_SIZE) + y * SECTION_SIZE + x);
+}
+
+Block	ChunkSection::getBlock(uint64_t x, uint64_t y, uint64_t z) const
+{
+	if (!_blocks)
+		return (_uniform);
+	return ((*_blocks)[_index(x, y, z)]);
+}
+
+void	ChunkSection::setBlock(uint64_t x, uint64_t y, uint64_t z, Block block)
+{
+	if (!_blocks)
+	{
+		if (block.getType() == _uniform.getType())
+			return ;
+		_blocks.reset(_newBlocks(_uniform));
+	}
+	(*_blocks)[_index(x, y, z)] = block;
+}
+
+void	ChunkSection::setColumn(uint64_t x, uint64_t z, const Block *blocks)
+{
+	if (!_blocks)
+	{
+		Block::Type	type = _uniform.getType();
+		if (std::all_of(blocks, blocks + SECTION_SIZE, [type](const Block &block) {return (block.getType() == type);}))
+			return ;
+		_blocks.reset(_newBlocks(_uniform));
+	}
+	for (uint64_t y = 0; y < SECTION_SIZE; ++y)
+		(*_blocks)[_index(x, y, z)] = blocks[y];
+}
+
+void	ChunkSection::copyRowTypes(uint64_t y, uint64_t z, uint8_t *dst) const
+{
+	if (!_blocks)
+	{
+		std::fill_n(dst, SECTION_SIZE, _uniform.getType());
+		return ;
+	}
+	const Block	*row = &(*_blocks)[_index(0, y, z)];
+	for (uint64_t x = 0; x < SECTION_SIZE; ++x)
+		dst[x] = row[x].getType();
+}
+
+bool	ChunkSection::isUniform() const
+{
+	return (!_blocks);
+}
+
+Block	ChunkSection::getUniformBlock() const
+{
+	return (_uniform);
+}
+
+void	ChunkSection::compact()
+{
+	if (!_blocks)
+		return ;
+	Block::Type	type = (*_blocks)[0].getType();
+	if (std::any_of(_blocks->begin(), _blocks->end(), [type](const Block &block) {return (block.getType() != type);}))
+		return ;
+	_uniform = Block(type);
+	_blocks.reset();
+}
+
+uint64_t	ChunkSection::getMemory() const
+{
+	if (!_blocks)
+		return (sizeof(ChunkSection));
+	return (sizeof(ChunkSection) + sizeof(Blocks));
+}
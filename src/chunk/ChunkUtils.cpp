@@ -4,34 +4,67 @@ Created on: 23/03/2026
 */
 
 #include "Chunk.hpp"
-#include "Coords.hpp"
+
+Block	ChunkSnapshot::getBlock(uint64_t x, uint64_t y, uint64_t z) const
+{
+	return (sections[y / SECTION_SIZE]->getBlock(x, y % SECTION_SIZE, z));
+}
+
+ChunkSnapshotPtr	Chunk::getSnapshot() const
+{
+	return (_snapshot.load());
+}
 
 Block	Chunk::getBlock(const mlm::ivec3 &blockChunkCoord)
 {
-	_blockMtx.lock();
-	Block ret = _blocks[index3D(blockChunkCoord)];
-	_blockMtx.unlock();
-	return (ret);
+	return (getSnapshot()->getBlock(blockChunkCoord.x, blockChunkCoord.y, blockChunkCoord.z));
 }
 
+// Copies the section containing the block, publishes it in a new snapshot and records the edit in the journal
 bool	Chunk::setBlock(const mlm::ivec3 &blockChunkCoord, Block block)
 {
-	bool ret = true;
-	_blockMtx.lock();
-	Block &target = _blocks[index3D(blockChunkCoord)];
-	if (target.getType() == block.getType())
-		ret = false;
-	target = block;
-	_blockMtx.unlock();
-	return (ret);
+	std::lock_guard<std::mutex>	lock(_blockMtx);
+	ChunkSnapshotPtr			current = getSnapshot();
+	if (current->getBlock(blockChunkCoord.x, blockChunkCoord.y, blockChunkCoord.z).getType() == block.getType())
+		return (false);
+
+	uint64_t						sectionY = blockChunkCoord.y / SECTION_SIZE;
+	std::shared_ptr<ChunkSection>	section = std::make_shared<ChunkSection>(*current->sections[sectionY]);
+	section->setBlock(blockChunkCoord.x, blockChunkCoord.y % SECTION_SIZE, blockChunkCoord.z, block);
+	section->compact();
+
+	std::shared_ptr<ChunkSnapshot>	next = std::make_shared<ChunkSnapshot>(*current);
+	next->sections[sectionY] = std::move(section);
+	next->version = current->version + 1;
+	_snapshot.store(std::move(next));
+	// Recorded before _blockMtx is released, a generate or load that publishes after this applies it
+	_manager.getEditJournal().record(_chunkPos, blockChunkCoord, block);
+	return (true);
 }
 
 Block::Type	Chunk::getBlockType(const mlm::ivec3 &blockChunkCoord)
 {
-	_blockMtx.lock();
-	Block::Type ret = _blocks[index3D(blockChunkCoord)].getType();
-	_blockMtx.unlock();
-	return (ret);
+	return (getBlock(blockChunkCoord).getType());
+}
+
+// Bytes used to store the blocks of this chunk, sections shared with other snapshots included
+uint64_t	Chunk::getBlockMemory()
+{
+	ChunkSnapshotPtr	snapshot = getSnapshot();
+	uint64_t			bytes = 0;
+	for (const std::shared_ptr<const ChunkSection> &section : snapshot->sections)
+		bytes += section->getMemory();
+	return (bytes);
+}
+
+uint64_t	Chunk::getVertexCapacity()
+{
+	return (_mesh.get_vertices().capacity() + _waterMesh.get_vertices().capacity());
+}
+
+uint64_t	Chunk::getGpuMemory()
+{
+	return (_mesh.get_gpu_bytes() + _waterMesh.get_gpu_bytes());
 }
 
 std::pair<mlm::vec3 &, mlm::vec3 &>	Chunk::getMinMax()
@@ -39,6 +72,16 @@ std::pair<mlm::vec3 &, mlm::vec3 &>	Chunk::getMinMax()
 	return (std::make_pair(std::reference_wrapper(_min), std::reference_wrapper(_max)));
 }
 
+ChunkMesh	&Chunk::getMesh()
+{
+	return (_mesh);
+}
+
+ChunkMesh	&Chunk::getWaterMesh()
+{
+	return (_waterMesh);
+}
+
 mlm::ivec2	Chunk::getChunkPos()
 {
 	return (_chunkPos);
@@ -51,15 +94,10 @@ mlm::ivec3	Chunk::getWorldPos()
 
 void	Chunk::setState(const Chunk::State state)
 {
-	_stateMtx.lock();
 	_state = state;
-	_stateMtx.unlock();
 }
 
 Chunk::State	Chunk::getState()
 {
-	_stateMtx.lock();
-	State ret = _state;
-	_stateMtx.unlock();
-	return (ret);
+	return (_state);
 }
@@ -0,0 +1,449 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "MeshCache.hpp"
+#include "Chunk.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <functional>
+#include <sstream>
+#include <sys/stat.h>
+#include <thread>
+#include <unistd.h>
+
+/*
+// Two independent hashes of the same input. The first one is the key, the second one is kept with the
+// entry and compared on every lookup, so two neighborhoods whose keys collide don't share a mesh
+*/
+struct MeshHasher {
+	uint64_t	hash = 0xCBF29CE484222325ULL;
+	uint64_t	check = 0x27D4EB2F165667C5ULL;
+
+	void	add(uint64_t value)
+	{
+		hash ^= value;
+		hash *= 0x9E3779B97F4A7C15ULL;
+		hash ^= hash >> 32;
+		// Round of xxHash64
+		check += value * 0xC2B2AE3D27D4EB4FULL;
+		check = std::rotl(check, 31);
+		check *= 0x9E3779B185EBCA87ULL;
+	}
+};
+
+// Row of SECTION_SIZE block types as 2 words
+static void	addRow(MeshHasher &hasher, const uint8_t *row)
+{
+	static_assert(SECTION_SIZE == 2 * sizeof(uint64_t), "A row has to be 2 words");
+	uint64_t	words[2];
+	std::memcpy(words, row, sizeof(words));
+	hasher.add(words[0]);
+	hasher.add(words[1]);
+}
+
+// Tags keep a uniform section or a missing neighbor from hashing the same as a row of blocks
+constexpr uint64_t	UNIFORM_TAG = 1ULL << 62;
+constexpr uint64_t	MISSING_TAG = 1ULL << 63;
+
+// Hashes the blocks of neighbor at x or z edge, the only ones meshing the center chunk reads
+static void	addBorder(MeshHasher &hasher, const ChunkSnapshotPtr &neighbor, bool alongX, uint64_t edge)
+{
+	if (!neighbor)
+	{
+		hasher.add(MISSING_TAG | edge | (alongX << 8));
+		return ;
+	}
+	for (const std::shared_ptr<const ChunkSection> &section : neighbor->sections)
+	{
+		if (section->isUniform())
+		{
+			hasher.add(UNIFORM_TAG | section->getUniformBlock().getType());
+			continue ;
+		}
+		uint8_t	row[SECTION_SIZE];
+		for (uint64_t y = 0; y < SECTION_SIZE; ++y)
+		{
+			if (alongX)
+				section->copyRowTypes(y, edge, row);
+			else
+				for (uint64_t z = 0; z < SECTION_SIZE; ++z)
+					row[z] = section->getBlock(edge, y, z).getType();
+			addRow(hasher, row);
+		}
+	}
+}
+
+MeshCache::MeshCache()
+{}
+
+MeshCache::~MeshCache()
+{}
+
+void	MeshCache::init(size_t capacityBytes, const std::string &spillPath, size_t spillCapacityBytes)
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	_capacity = capacityBytes;
+	_spillPath = spillPath;
+	_spillCapacity = spillCapacityBytes;
+	_spillLru.clear();
+	_spillIndex.clear();
+	_spillBytes = 0;
+	if (_spillPath.empty() == false)
+	{
+		std::filesystem::create_directories(_spillPath);
+		_loadSpillIndex();
+	}
+}
+
+bool	MeshCache::isEnabled() const
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	return (_capacity > 0);
+}
+
+MeshCache::Key	MeshCache::hash(const ChunkNeighborhood &area, bool greedyMeshing)
+{
+	MeshHasher	hasher;
+	hasher.add(greedyMeshing);
+	for (const std::shared_ptr<const ChunkSection> &section : area.center->sections)
+	{
+		if (section->isUniform())
+		{
+			hasher.add(UNIFORM_TAG | section->getUniformBlock().getType());
+			continue ;
+		}
+		uint8_t	row[SECTION_SIZE];
+		for (uint64_t z = 0; z < SECTION_SIZE; ++z)
+		{
+			for (uint64_t y = 0; y < SECTION_SIZE; ++y)
+			{
+				section->copyRowTypes(y, z, row);
+				addRow(hasher, row);
+			}
+		}
+	}
+	addBorder(hasher, area.west, false, CHUNK_SIZE_X - 1);
+	addBorder(hasher, area.east, false, 0);
+	addBorder(hasher, area.north, true, CHUNK_SIZE_Z - 1);
+	addBorder(hasher, area.south, true, 0);
+	// Final avalanche, so every input bit reaches every output bit
+	Key	key = {hasher.hash, hasher.check};
+	key.hash ^= key.hash >> 31;
+	key.hash *= 0xBF58476D1CE4E5B9ULL;
+	key.hash ^= key.hash >> 29;
+	key.check ^= key.check >> 33;
+	key.check *= 0xC2B2AE3D27D4EB4FULL;
+	key.check ^= key.check >> 29;
+	return (key);
+}
+
+MeshCache::EntryPtr	MeshCache::find(const Key &key)
+{
+	EntryPtr	entry = nullptr;
+	_mtx.lock();
+	auto		it = _index.find(key.hash);
+	if (it != _index.end())
+	{
+		// Move to the front, it's the most recently used now
+		_lru.splice(_lru.begin(), _lru, it->second);
+		if (it->second->check == key.check)
+			entry = it->second->entry;
+		else
+			_collisions++;
+	}
+	bool		spill = !entry && it == _index.end() && _spillIndex.contains(key.hash);
+	_mtx.unlock();
+
+	if (spill && (entry = _readSpill(key)) != nullptr)
+	{
+		_spillHits++;
+		insert(key, entry);
+	}
+	if (!entry)
+	{
+		_misses++;
+		return (nullptr);
+	}
+	_hits++;
+	_microsecondsSaved += entry->microseconds;
+	return (entry);
+}
+
+void	MeshCache::insert(const Key &key, EntryPtr entry)
+{
+	std::vector<Slot>	evicted;
+	_mtx.lock();
+	if (_capacity > 0)
+		_insert({key.hash, key.check, std::move(entry)}, evicted);
+	bool				spill = _spillPath.empty() == false;
+	_mtx.unlock();
+	// Written without holding the lock, other workers keep using the cache meanwhile
+	if (spill)
+		for (const Slot &slot : evicted)
+			_spill(slot);
+}
+
+void	MeshCache::clear()
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	_index.clear();
+	_lru.clear();
+	_bytes = 0;
+}
+
+MeshCache::Stats	MeshCache::getStats() const
+{
+	Stats	stats = {_hits, _spillHits, _misses, _collisions, _microsecondsSaved};
+	return (stats);
+}
+
+size_t	MeshCache::getBytes() const
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	return (_bytes);
+}
+
+size_t	MeshCache::getSpillBytes() const
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	return (_spillBytes);
+}
+
+void	MeshCache::_insert(Slot slot, std::vector<Slot> &evicted)
+{
+	auto	it = _index.find(slot.key);
+	if (it != _index.end())
+	{
+		_bytes -= _entryBytes(*it->second->entry);
+		_lru.erase(it->second);
+	}
+	_bytes += _entryBytes(*slot.entry);
+	_lru.push_front(std::move(slot));
+	_index[_lru.front().key] = _lru.begin();
+	// The entry just inserted is kept even if it's larger than the whole cache
+	while (_bytes > _capacity && _lru.size() > 1)
+	{
+		Slot	&oldest = _lru.back();
+		_bytes -= _entryBytes(*oldest.entry);
+		_index.erase(oldest.key);
+		evicted.push_back(std::move(oldest));
+		_lru.pop_back();
+	}
+}
+
+// Writes an evicted mesh to disk unless the same one is already there, then drops the oldest files over capacity
+void	MeshCache::_spill(const Slot &slot)
+{
+	_mtx.lock();
+	auto	it = _spillIndex.find(slot.key);
+	bool	written = it != _spillIndex.end() && it->second->check == slot.check;
+	if (written)
+		_spillLru.splice(_spillLru.begin(), _spillLru, it->second);
+	_mtx.unlock();
+	if (written)
+		return ;
+
+	size_t					size = _writeSpill(slot);
+	std::vector<uint64_t>	removed;
+	_mtx.lock();
+	if (size > 0)
+		_addSpill({slot.key, slot.check, size});
+	_trimSpill(removed);
+	_mtx.unlock();
+	std::error_code	error;
+	for (uint64_t key : removed)
+		std::filesystem::remove(_spillFile(key), error);
+}
+
+// Only called while holding _mtx, replaces the file of the same key if there is one
+void	MeshCache::_addSpill(const SpillFile &file)
+{
+	auto	it = _spillIndex.find(file.key);
+	if (it != _spillIndex.end())
+	{
+		_spillBytes -= it->second->size;
+		_spillLru.erase(it->second);
+	}
+	_spillBytes += file.size;
+	_spillLru.push_front(file);
+	_spillIndex[file.key] = _spillLru.begin();
+}
+
+/*
+// Picks up the meshes spilled by earlier sessions, least recently written ones last.
+// Files that aren't spilled meshes, like temporary files of a write that was cut off, are removed.
+// The check of a file is only known once it's read, until then it is 0
+*/
+void	MeshCache::_loadSpillIndex()
+{
+	std::vector<std::pair<std::filesystem::file_time_type, SpillFile>>	files;
+	std::error_code														error;
+	for (const std::filesystem::directory_entry &file : std::filesystem::directory_iterator(_spillPath, error))
+	{
+		const std::filesystem::path	&path = file.path();
+		char						*end = nullptr;
+		std::string					stem = path.stem().string();
+		uint64_t					key = std::strtoull(stem.c_str(), &end, 16);
+		if (path.extension() != ".mesh" || stem.empty() || *end != '\0' || file.is_regular_file(error) == false)
+		{
+			std::filesystem::remove(path, error);
+			continue ;
+		}
+		files.push_back({file.last_write_time(error), {key, 0, static_cast<size_t>(file.file_size(error))}});
+	}
+	std::sort(files.begin(), files.end(), [](const auto &a, const auto &b) {return (a.first < b.first);});
+	for (const auto &[time, file] : files)
+		_addSpill(file);
+	// The capacity can be smaller than last session
+	std::vector<uint64_t>	removed;
+	_trimSpill(removed);
+	for (uint64_t key : removed)
+		std::filesystem::remove(_spillFile(key), error);
+}
+
+// Only called while holding _mtx, the files of the removed keys are deleted by the caller without it
+void	MeshCache::_trimSpill(std::vector<uint64_t> &removed)
+{
+	while (_spillBytes > _spillCapacity && _spillLru.empty() == false)
+	{
+		SpillFile	&oldest = _spillLru.back();
+		_spillBytes -= oldest.size;
+		_spillIndex.erase(oldest.key);
+		removed.push_back(oldest.key);
+		_spillLru.pop_back();
+	}
+}
+
+std::string	MeshCache::_spillFile(uint64_t key) const
+{
+	std::ostringstream	name;
+	name << _spillPath << std::hex << key << ".mesh";
+	return (name.str());
+}
+
+/*
+// Spill file: magic, version, check, min, max, build time, vertex count, water vertex count,
+// then the vertices followed by the water vertices
+*/
+MeshCache::EntryPtr	MeshCache::_readSpill(const Key &key)
+{
+	int	fd = open(_spillFile(key.hash).c_str(), O_RDONLY);
+	if (fd < 0)
+		return (nullptr);
+	std::vector<uint8_t>	data;
+	struct stat				info;
+	if (fstat(fd, &info) == 0)
+	{
+		data.resize(info.st_size);
+		if (read(fd, data.data(), data.size()) != static_cast<ssize_t>(data.size()))
+			data.clear();
+	}
+	close(fd);
+
+	const size_t	headerSize = sizeof(MAGIC) + sizeof(VERSION) + sizeof(uint64_t) + 6 * sizeof(float) + 3 * sizeof(uint64_t);
+	if (data.size() < headerSize || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0)
+		return (nullptr);
+	uint32_t	version;
+	uint64_t	check;
+	float		bounds[6];
+	uint64_t	sizes[3];
+	size_t		offset = sizeof(MAGIC);
+	std::memcpy(&version, data.data() + offset, sizeof(version));
+	offset += sizeof(version);
+	std::memcpy(&check, data.data() + offset, sizeof(check));
+	offset += sizeof(check);
+	std::memcpy(bounds, data.data() + offset, sizeof(bounds));
+	offset += sizeof(bounds);
+	std::memcpy(sizes, data.data() + offset, sizeof(sizes));
+	if (version != VERSION || data.size() != headerSize + (sizes[1] + sizes[2]) * sizeof(ChunkVertex))
+		return (nullptr);
+	if (check != key.check)
+	{
+		_collisions++;
+		return (nullptr);
+	}
+
+	std::shared_ptr<Entry>	entry = std::make_shared<Entry>();
+	entry->min = mlm::vec3(bounds[0], bounds[1], bounds[2]);
+	entry->max = mlm::vec3(bounds[3], bounds[4], bounds[5]);
+	entry->microseconds = sizes[0];
+	std::shared_ptr<std::vector<ChunkVertex>>	vertices = std::make_shared<std::vector<ChunkVertex>>(sizes[1]);
+	std::shared_ptr<std::vector<ChunkVertex>>	waterVertices = std::make_shared<std::vector<ChunkVertex>>(sizes[2]);
+	if (sizes[1] > 0)
+		std::memcpy(vertices->data(), data.data() + headerSize, sizes[1] * sizeof(ChunkVertex));
+	if (sizes[2] > 0)
+		std::memcpy(waterVertices->data(), data.data() + headerSize + sizes[1] * sizeof(ChunkVertex), sizes[2] * sizeof(ChunkVertex));
+	entry->vertices = std::move(vertices);
+	entry->waterVertices = std::move(waterVertices);
+
+	// Read recently, so it's the last file to be dropped
+	_mtx.lock();
+	if (auto it = _spillIndex.find(key.hash); it != _spillIndex.end())
+	{
+		it->second->check = check;
+		_spillLru.splice(_spillLru.begin(), _spillLru, it->second);
+	}
+	_mtx.unlock();
+	return (entry);
+}
+
+// Written to a file of its own first, so a reader never sees half a mesh. Returns the size of the file, 0 if it couldn't be written
+size_t	MeshCache::_writeSpill(const Slot &slot) const
+{
+	const Entry	&entry = *slot.entry;
+	float		bounds[6] = {entry.min.x, entry.min.y, entry.min.z, entry.max.x, entry.max.y, entry.max.z};
+	uint64_t	sizes[3] = {entry.microseconds, entry.vertices->size(), entry.waterVertices->size()};
+	size_t		vertexBytes = entry.vertices->size() * sizeof(ChunkVertex);
+	size_t		waterBytes = entry.waterVertices->size() * sizeof(ChunkVertex);
+	size_t		headerSize = sizeof(MAGIC) + sizeof(VERSION) + sizeof(slot.check) + sizeof(bounds) + sizeof(sizes);
+	std::vector<uint8_t>	data(headerSize + vertexBytes + waterBytes);
+	size_t		offset = 0;
+	std::memcpy(data.data() + offset, MAGIC, sizeof(MAGIC));
+	offset += sizeof(MAGIC);
+	std::memcpy(data.data() + offset, &VERSION, sizeof(VERSION));
+	offset += sizeof(VERSION);
+	std::memcpy(data.data() + offset, &slot.check, sizeof(slot.check));
+	offset += sizeof(slot.check);
+	std::memcpy(data.data() + offset, bounds, sizeof(bounds));
+	offset += sizeof(bounds);
+	std::memcpy(data.data() + offset, sizes, sizeof(sizes));
+	if (vertexBytes > 0)
+		std::memcpy(data.data() + headerSize, entry.vertices->data(), vertexBytes);
+	if (waterBytes > 0)
+		std::memcpy(data.data() + headerSize + vertexBytes, entry.waterVertices->data(), waterBytes);
+
+	std::string	path = _spillFile(slot.key);
+	std::string	tmpPath = path + "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+	int			fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+	{
+		Logger::error("MeshCache: " + tmpPath + ": open failed: " + std::strerror(errno));
+		return (0);
+	}
+	bool		written = write(fd, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+	close(fd);
+	std::error_code	error;
+	if (written)
+		std::filesystem::rename(tmpPath, path, error);
+	if (!written || error)
+	{
+		Logger::error("MeshCache: " + path + ": write failed");
+		std::filesystem::remove(tmpPath, error);
+		return (0);
+	}
+	return (data.size());
+}
+
+size_t	MeshCache::_entryBytes(const Entry &entry)
+{
+	// Shared with chunk meshes, but held on to for as long as the entry is cached
+	return (sizeof(Entry) + (entry.vertices->capacity() + entry.waterVertices->capacity()) * sizeof(ChunkVertex));
+}
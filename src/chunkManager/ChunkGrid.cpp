@@ -0,0 +1,88 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "ChunkGrid.hpp"
+#include "Chunk.hpp"
+
+#include <utility>
+
+ChunkGrid::ChunkGrid()
+{}
+
+ChunkGrid::~ChunkGrid()
+{}
+
+void	ChunkGrid::init(int radius)
+{
+	_size = 2 * radius + 1;
+	_slots = std::vector<std::atomic<std::shared_ptr<Chunk>>>(static_cast<size_t>(_size) * _size);
+	_count = 0;
+}
+
+std::shared_ptr<Chunk>	ChunkGrid::get(const mlm::ivec2 &chunkPos) const
+{
+	if (_size == 0)
+		return (nullptr);
+	std::shared_ptr<Chunk>	chunk = _getSlot(chunkPos).load();
+	if (!chunk || chunk->getChunkPos() != chunkPos)
+		return (nullptr);
+	return (chunk);
+}
+
+bool	ChunkGrid::isFree(const mlm::ivec2 &chunkPos) const
+{
+	if (_size == 0)
+		return (false);
+	std::shared_ptr<Chunk>	chunk = _getSlot(chunkPos).load();
+	return (!chunk || chunk->getChunkPos() == chunkPos);
+}
+
+bool	ChunkGrid::insert(std::shared_ptr<Chunk> chunk)
+{
+	if (!chunk || isFree(chunk->getChunkPos()) == false)
+		return (false);
+	std::shared_ptr<Chunk>	old = _getSlot(chunk->getChunkPos()).exchange(chunk);
+	if (!old)
+		_count++;
+	return (true);
+}
+
+void	ChunkGrid::erase(const mlm::ivec2 &chunkPos)
+{
+	if (!get(chunkPos))
+		return ;
+	_getSlot(chunkPos).store(nullptr);
+	_count--;
+}
+
+void	ChunkGrid::clear()
+{
+	for (std::atomic<std::shared_ptr<Chunk>> &slot : _slots)
+		slot.store(nullptr);
+	_count = 0;
+}
+
+size_t	ChunkGrid::getCount() const
+{
+	return (_count);
+}
+
+int	ChunkGrid::getSize() const
+{
+	return (_size);
+}
+
+// Wraps negative coordinates around too, -1 ends up in the last slot of a row
+const std::atomic<std::shared_ptr<Chunk>>	&ChunkGrid::_getSlot(const mlm::ivec2 &chunkPos) const
+{
+	int	x = ((chunkPos.x % _size) + _size) % _size;
+	int	z = ((chunkPos.y % _size) + _size) % _size;
+	return (_slots[static_cast<size_t>(z) * _size + x]);
+}
+
+std::atomic<std::shared_ptr<Chunk>>	&ChunkGrid::_getSlot(const mlm::ivec2 &chunkPos)
+{
+	return (const_cast<std::atomic<std::shared_ptr<Chunk>> &>(std::as_const(*this)._getSlot(chunkPos)));
+}
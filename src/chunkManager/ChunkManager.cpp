@@ -9,24 +9,45 @@ Created on: 19/08/2025
 #include "Coords.hpp"
 #include "Logger.hpp"
 
+#include <algorithm>
+#include <cmath>
 #include <memory>
 
 int	getChunkCount();
 
+// Jobs are keyed by the chunk they are for, packed like ivec2Hash
+static mlm::ivec2	unpackChunkPos(uint64_t key)
+{
+	return (mlm::ivec2(static_cast<int32_t>(static_cast<uint32_t>(key)), static_cast<int32_t>(static_cast<uint32_t>(key >> 32))));
+}
+
 bool	ChunkManager::_loadChunk(const mlm::ivec2 &chunkCoord)
 {
-	_chunksMtx.lock();
-	if (_chunks[chunkCoord] != nullptr)
-	{
-		_chunksMtx.unlock();
+	// The slot can still hold a chunk that is waiting to be unloaded, it's loaded again once that is gone
+	if (_chunks.get(chunkCoord) || _chunks.isFree(chunkCoord) == false)
 		return (false);
-	}
-	_chunksMtx.unlock();
 
-	std::shared_ptr<Chunk>	chunk = std::make_shared<Chunk>(chunkCoord, *this);
-	_chunksMtx.lock();
-	_chunks[chunkCoord] = std::move(chunk);
-	_chunksMtx.unlock();
+	std::shared_ptr<Chunk>	chunk;
+	auto					cached = _unloadedIndex.find(chunkCoord);
+	if (cached != _unloadedIndex.end())
+	{
+		// Comes back in the state it was unloaded in, an uploaded chunk is visible right away
+		chunk = std::move(*cached->second);
+		_unloadedChunks.erase(cached->second);
+		_unloadedIndex.erase(cached);
+		_cacheStats.hits++;
+		_cacheStats.regenerationsAvoided++;
+		if (chunk->getState() >= Chunk::MESHED)
+			_cacheStats.remeshesAvoided++;
+	}
+	else
+	{
+		chunk = _chunkPool.acquire(chunkCoord, *this);
+		_cacheStats.misses++;
+	}
+	_chunks.insert(chunk);
+	// A chunk from the cache can be the last neighbor another chunk was waiting on to be meshed
+	_onChunkChanged(chunk);
 	return (true);
 }
 
@@ -34,63 +55,136 @@ void	ChunkManager::_unloadChunk(std::shared_ptr<Chunk> &chunk)
 {
 	if (!chunk)
 		return ;
-	const mlm::ivec2	&chunkCoord = chunk->getChunkPos();
-	_chunksMtx.lock();
+	const mlm::ivec2	chunkCoord = chunk->getChunkPos();
 	_chunks.erase(chunkCoord);
-	_chunksMtx.unlock();
+	// Chunks that were never generated are cheaper to create again than to keep
+	if (_unloadCacheSize == 0 || chunk->getState() < Chunk::GENERATED)
+	{
+		_saveChunk(chunk);
+		return ;
+	}
+	if (_cacheMeshes == false)
+		chunk->releaseMesh();
+	// Was set when the chunk was queued for unloading
+	chunk->_busy = false;
+	_unloadedChunks.push_front(chunk);
+	_unloadedIndex[chunkCoord] = _unloadedChunks.begin();
+	while (_unloadedChunks.size() > _unloadCacheSize)
+	{
+		std::shared_ptr<Chunk>	&oldest = _unloadedChunks.back();
+		_saveChunk(oldest);
+		_unloadedIndex.erase(oldest->getChunkPos());
+		_unloadedChunks.pop_back();
+	}
 }
 
-void	ChunkManager::_ThreadRoutine()
+void	ChunkManager::_markDirty(const mlm::ivec2 &chunkCoord)
 {
-	while(_running)
+	std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
+	if (chunk)
 	{
-		// Periodically check for tasks in the queue
-		_queueMtx.lock();
-		if (_queue.empty())
-		{
-			_queueMtx.unlock();
-			usleep(100);
-			continue ;
-		}
-
-		// Access task from queue
-		ChunkTask task = _popFromQueue();
-		_queueMtx.unlock();
-
-		// Attempt to convert the tasks chunk weak_ptr to shared_ptr
-		std::shared_ptr<Chunk> chunk = task.ptr.lock();
-		// If this returns nullptr, the chunk has since been unloaded
-		if (!chunk)
-		{
-			Logger::log("tried to access unloaded chunk!");
-			continue ;
-		}
-		// Run appropiate task
-		switch (task.type)
-		{
-			case ChunkTask::Type::GENERATE:
-				chunk->generate(std::atomic_load(&_generator));
-				break;
-			case ChunkTask::Type::MESH:
-				chunk->mesh();
-				break;
-		}
-		_updateVisibility = true;
+		chunk->_dirty = true;
+		_dispatchChunk(chunk);
 	}
+	auto	cached = _unloadedIndex.find(chunkCoord);
+	if (cached != _unloadedIndex.end())
+		(*cached->second)->_dirty = true;
+}
+
+void	ChunkManager::_clearUnloadCache()
+{
+	_unloadedIndex.clear();
+	_unloadedChunks.clear();
+}
+
+void	ChunkManager::_saveChunk(std::shared_ptr<Chunk> &chunk)
+{
+	if (!chunk || _storage.isRunning() == false || chunk->getState() < Chunk::GENERATED)
+		return ;
+	ChunkSnapshotPtr	snapshot = chunk->getSnapshot();
+	if (snapshot->version == chunk->_savedVersion)
+		return ;
+	_storage.write(chunk->getChunkPos(), snapshot);
+	chunk->_savedVersion = snapshot->version;
+}
+
+void	ChunkManager::_saveAll()
+{
+	_chunks.forEach([this](std::shared_ptr<Chunk> &chunk) {_saveChunk(chunk);});
+	for (std::shared_ptr<Chunk> &chunk : _unloadedChunks)
+		_saveChunk(chunk);
+}
+
+void	ChunkManager::_runTask(const ChunkTask &task)
+{
+	// Attempt to convert the tasks chunk weak_ptr to shared_ptr
+	std::shared_ptr<Chunk> chunk = task.ptr.lock();
+	// If this returns nullptr, the chunk has since been unloaded
+	if (!chunk)
+	{
+		Logger::log("tried to access unloaded chunk!");
+		return ;
+	}
+	// Run appropiate task
+	switch (task.type)
+	{
+		case ChunkTask::Type::GENERATE:
+			chunk->generate(std::atomic_load(&_generator));
+			break;
+		case ChunkTask::Type::MESH:
+			chunk->mesh();
+			break;
+	}
+	_pushCompleted(task.chunkPos);
 }
 
 void	ChunkManager::_addToQueue(std::shared_ptr<Chunk> &chunk, ChunkTask::Type type)
 {
-	_queueMtx.lock();
-	_queue.push_back({chunk, type});
-	_queueMtx.unlock();
+	ChunkTask	task = {chunk, type, chunk->getChunkPos()};
+	_jobs.submit([this, task]() {_runTask(task);}, _getTaskPriority(task.chunkPos), ivec2Hash()(task.chunkPos));
+}
+
+/*
+// Distance to the camera chunk in whole chunks, chunks outside of the view frustum count as twice as far away.
+// Only called on the main thread, since it reads the frustum
+*/
+size_t	ChunkManager::_getTaskPriority(const mlm::ivec2 &chunkPos)
+{
+	mlm::vec2	offset = static_cast<mlm::vec2>(chunkPos - _cameraChunkCoord);
+	float		priority = offset.x * offset.x + offset.y * offset.y;
+
+	mlm::vec3	cameraPos = _engine.getCamera().getPos();
+	mlm::vec3	worldPos(chunkPos.x * static_cast<int>(CHUNK_SIZE_X), 0.0f, chunkPos.y * static_cast<int>(CHUNK_SIZE_Z));
+	mlm::vec3	min = worldPos - cameraPos;
+	mlm::vec3	max = min + mlm::vec3(CHUNK_SIZE_X, CHUNK_SIZE_Y, CHUNK_SIZE_Z);
+	if (_engine.getFrustum().isBoxVisible(AABB(min, max)) == false)
+		priority = priority * 4.0f + 1.0f;
+	return (static_cast<size_t>(std::sqrt(priority)));
+}
+
+// Recalculates the priority of every waiting task, and cancels the ones outside of render distance
+void	ChunkManager::_reprioritizeTasks()
+{
+	uint64_t	cancelled = 0;
+	_jobs.reprioritize([this, &cancelled](uint64_t key) {
+		mlm::ivec2	chunkPos = unpackChunkPos(key);
+		if (_isInRenderRange(chunkPos))
+			return (_getTaskPriority(chunkPos));
+		// Chunk is no longer queued, so it can be unloaded or queued again. A busy chunk stays in its slot
+		std::shared_ptr<Chunk>	chunk = _chunks.get(chunkPos);
+		if (chunk)
+			chunk->_busy = false;
+		cancelled++;
+		return (JobSystem::CANCELLED);
+	});
+	if (cancelled > 0)
+		Logger::info("Cancelled " + std::to_string(cancelled) + " chunk tasks outside of render distance");
 }
 
-ChunkManager::ChunkTask	ChunkManager::_popFromQueue()
+// Drops every waiting task, for when the chunks they are for are no longer in the grid
+void	ChunkManager::_cancelTasks()
 {
-	ChunkManager::ChunkTask ret = _queue.front();
-	_queue.pop_front();
-	return (ret);
+	_jobs.reprioritize([](uint64_t) {return (JobSystem::CANCELLED);});
 }
 
 void	ChunkManager::renderChunks(Shader &shader)
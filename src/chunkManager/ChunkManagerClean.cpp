@@ -4,6 +4,7 @@ Created on: 10/03/2026
 */
 
 #include "ChunkManager.hpp"
+#include "BlockPool.hpp"
 #include "Logger.hpp"
 
 ChunkManager::~ChunkManager()
@@ -13,9 +14,8 @@ void	ChunkManager::cleanup()
 {
 	// Join threads before clearing chunks to avoid heap-use-after-free on chunks
 	Logger::info("Joining threads");
-	_running = false;
-	for (auto &thread : _threads)
-		thread.join();
+	_jobs.stop();
+	_stopSaving();
 	// Clear chunk lists before chunk map
 	_chunkLoadList.clear();
 	_chunkGenerateList.clear();
@@ -27,4 +27,16 @@ void	ChunkManager::cleanup()
 
 	Logger::info("Clearing chunks");
 	_chunks.clear();
+	_clearUnloadCache();
+	_chunkPool.clear();
+	BlockPool::clear();
+	ChunkMesh::delQuadIndices();
+}
+
+// Saves what is still loaded, the storage thread writes everything queued before it stops
+void	ChunkManager::_stopSaving()
+{
+	_saveAll();
+	_storage.stop();
+	_journal.stop();
 }
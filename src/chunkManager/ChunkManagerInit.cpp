@@ -6,6 +6,7 @@ Created on: 10/03/2026
 #include "ChunkManager.hpp"
 #include "VoxEngine.hpp"
 #include "Settings.hpp"
+#include "BlockPool.hpp"
 #include "Logger.hpp"
 
 ChunkManager::ChunkManager(VoxEngine &engine): _engine(engine)
@@ -18,13 +19,43 @@ void	ChunkManager::init(const ChunkManagerDTO &dto)
 	_maxLoad = static_cast<int>(dto.maxLoad);
 	_maxGenerate = static_cast<int>(dto.maxGenerate);
 	_maxMesh = static_cast<int>(dto.maxMesh);
+	_greedyMeshing = dto.greedyMeshing;
+	_freeMeshVertices = dto.freeMeshVertices;
+	_saveEdits = dto.saveEdits;
+	_cacheChunks = dto.cacheChunks;
+	_savePath = dto.savePath;
+	_mmapReads = dto.mmapReads;
+	_unloadMargin = static_cast<int>(dto.unloadMargin);
+	_unloadCacheSize = static_cast<size_t>(dto.unloadCacheSize);
+	_cacheMeshes = dto.cacheMeshes;
+	_chunks.init(_renderDistance + _unloadMargin);
+	_chunkPool.init(static_cast<size_t>(dto.chunkPoolSize));
+	BlockPool::configure(static_cast<size_t>(dto.blockPoolSize) * 1024 * 1024, dto.hugePages);
+	// Meshes only depend on blocks, so the spilled ones are shared between seeds
+	_meshCache.init(static_cast<size_t>(dto.meshCacheSize) * 1024 * 1024, dto.meshCacheSpill ? _savePath + "meshes/" : "",
+		static_cast<size_t>(dto.meshSpillSize) * 1024 * 1024);
 
 	_updateCameraChunkCoord();
-	_threads.reserve(_threadCount);
 	// Create shared pointer for the terrain generator used by all the chunks
 	Logger::info("Loading terrain generator");
 	_generator.store(std::make_shared<TerrainGenerator>(Settings::loadTerrainGenerator()));
 	Logger::info("Creating threads");
-	for (int i = 0; i < _threadCount; ++i)
-		_threads.emplace_back(&ChunkManager::_ThreadRoutine, this);
+	_jobs.start(_threadCount);
+	_startSaving();
+}
+
+// Every seed gets its own directory, edits and chunks of another seed would never match the terrain around them
+void	ChunkManager::_startSaving()
+{
+	std::string	path = _savePath + std::to_string(std::atomic_load(&_generator)->getSeed()) + "/";
+	if (_saveEdits == true)
+	{
+		Logger::info("Loading edits from " + path);
+		_journal.start(path);
+	}
+	if (_cacheChunks == true)
+	{
+		Logger::info("Caching chunks in " + path);
+		_storage.start(path, _mmapReads);
+	}
 }
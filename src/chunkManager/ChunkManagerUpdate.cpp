@@ -6,104 +6,112 @@ Created on: 10/03/2026
 #include "ChunkManager.hpp"
 #include "VoxEngine.hpp"
 #include "Coords.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
 
 void	ChunkManager::update()
 {
+	// Walk render distance only when the camera entered another chunk
+	_updateCameraChunkCoord();
+	_updateVisibleList();
+	// Everything else reacts to the chunks that changed since the last update
+	_drainCompleted();
+
 	// Update chunk states
 	_updateLoadList();
 	_updateGenerateList();
 	_updateMeshList();
 	_updateUnloadList();
 	_updateUploadList();
-
-	// Determine what chunks go where
-	_updateVisibleList();
+	_updateTimeToVisible();
+	// Chunks whose last reference was dropped on a worker still have GPU buffers
+	_chunkPool.collect();
 
 	// Update rendering lists
+	_sortVisibleList();
 	_updateRenderList();
 	_updateShadowRenderList();
-	_updateCameraChunkCoord();
 }
 
 void	ChunkManager::_updateLoadList()
 {
-	int	loadCount = 0;
+	int						loadCount = 0;
+	std::vector<mlm::ivec2>	remaining;
 	for (const mlm::ivec2 &pos : _chunkLoadList)
 	{
-		if (loadCount >= _maxLoad)
-			break ;
-		if (_loadChunk(pos) == true)
+		if (_chunks.get(pos))
+			continue ;
+		// Over budget, or the slot still holds a chunk waiting to be unloaded. Tried again next update
+		if (loadCount >= _maxLoad || _loadChunk(pos) == false)
 		{
-			loadCount++;
-			_updateVisibility = true;
+			remaining.push_back(pos);
+			continue ;
 		}
+		loadCount++;
 	}
-	_chunkLoadList.clear();
+	_chunkLoadList.swap(remaining);
 }
 
 void	ChunkManager::_updateGenerateList()
 {
-	int	generateCount = 0;
-	for (std::shared_ptr<Chunk> chunk : _chunkGenerateList)
+	int									generateCount = 0;
+	std::vector<std::shared_ptr<Chunk>>	remaining;
+	for (std::shared_ptr<Chunk> &chunk : _chunkGenerateList)
 	{
+		// Only generate chunk if it isn't in the queue, and is still loaded and in render distance
+		if (chunk->getState() != Chunk::LOADED || chunk->_busy == true || _chunks.get(chunk->getChunkPos()) != chunk
+			|| _isInRenderRange(chunk->getChunkPos()) == false)
+			continue ;
 		if (generateCount >= _maxGenerate)
-			break ;
-		if (chunk && chunk->getState() == Chunk::LOADED)
 		{
-			// Only generate chunk if it isn't in the queue
-			if (chunk->_busy == false)
-			{
-				chunk->_busy = true;
-				_addToQueue(chunk, ChunkTask::Type::GENERATE);
-			}
-			generateCount++;
-			_updateVisibility = true;
+			remaining.push_back(chunk);
+			continue ;
+		}
+		chunk->_busy = true;
+		// Loading a saved chunk is cheaper than generating it again, and keeps the blocks placed in it.
+		// A chunk that turns out not to be saved comes back LOADED, by then its region file is open and it gets generated
+		if (_storage.mayContain(chunk->getChunkPos()))
+		{
+			std::weak_ptr<Chunk>	weak = chunk;
+			_storage.read(chunk->getChunkPos(), [this, weak](ChunkSnapshotPtr snapshot) {
+				std::shared_ptr<Chunk>	loaded = weak.lock();
+				if (!loaded)
+					return ;
+				// Chunk stays LOADED when it couldn't be read, so it gets generated instead
+				if (snapshot)
+					loaded->load(snapshot);
+				else
+					loaded->_busy = false;
+				_pushCompleted(loaded->getChunkPos());
+			});
 		}
+		else
+			_addToQueue(chunk, ChunkTask::Type::GENERATE);
+		generateCount++;
 	}
-	_chunkGenerateList.clear();
+	_chunkGenerateList.swap(remaining);
 }
 
 void	ChunkManager::_updateMeshList()
 {
-	const std::vector<mlm::ivec2>	neighbors = {
-		mlm::ivec2(0, 1),
-		mlm::ivec2(0, -1),
-		mlm::ivec2(1, 0),
-		mlm::ivec2(-1, 0),
-	};
-	int	meshCount = 0;
-	for (std::shared_ptr<Chunk> chunk : _chunkMeshList)
+	int									meshCount = 0;
+	std::vector<std::shared_ptr<Chunk>>	remaining;
+	for (std::shared_ptr<Chunk> &chunk : _chunkMeshList)
 	{
-		if (meshCount >= _maxMesh)
-			break ;
-		// Is chunk valid target for meshing
-		if (!chunk || (chunk->getState() != Chunk::GENERATED && chunk->_dirty == false))
+		// Dropped if it got queued, unloaded or lost a neighbor since, the next change queues it again
+		if (_isMeshReady(chunk) == false)
 			continue ;
-
-		// Check whether all neighboring chunks are generated before meshing
-		uint64_t	neighborSetupCount = 0;
-		for (const mlm::ivec2 &neighbor : neighbors)
-		{
-			_chunksMtx.lock();
-			std::shared_ptr<Chunk>	chunkNeighbor = _chunks[chunk->getChunkPos() - neighbor];
-			_chunksMtx.unlock();
-			// If neighbor is only loaded at best don't count it
-			if (!chunkNeighbor || chunkNeighbor->getState() < Chunk::DIRTY)
-				break ;
-			neighborSetupCount++;
-		}
-		if (neighborSetupCount < neighbors.size())
-			continue;
-		// Only mesh chunk if it isn't in the queue
-		if (chunk->_busy == false)
+		if (meshCount >= _maxMesh)
 		{
-			chunk->_busy = true;
-			_addToQueue(chunk, ChunkTask::Type::MESH);
+			remaining.push_back(chunk);
+			continue ;
 		}
+		chunk->_busy = true;
+		_addToQueue(chunk, ChunkTask::Type::MESH);
 		meshCount++;
-		_updateVisibility = true;
 	}
-	_chunkMeshList.clear();
+	_chunkMeshList.swap(remaining);
 }
 
 void	ChunkManager::_updateUnloadList()
@@ -114,7 +122,7 @@ void	ChunkManager::_updateUnloadList()
 		if (chunk && chunk->getState() != Chunk::UNLOADED)
 		{
 			_unloadChunk(chunk);
-			_updateVisibility = true;
+			_visibleChanged = true;
 		}
 	}
 	if (_chunkUnloadList.size() > 0)
@@ -128,38 +136,39 @@ void	ChunkManager::_updateUploadList()
 	// Upload all chunks with meshes ready to be sent to GPU
 	for (std::shared_ptr<Chunk> chunk : _chunkUploadList)
 	{
-		if (chunk)
+		if (chunk && _chunks.get(chunk->getChunkPos()) == chunk)
 		{
 			chunk->upload();
-			_updateVisibility = true;
+			_chunkVisibleList.push_back(chunk);
+			_visibleChanged = true;
 		}
 	}
 	_chunkUploadList.clear();
 }
 
+// Walks every chunk coordinate within render distance, and puts every chunk in the list of its next step
 void	ChunkManager::_updateVisibleList()
 {
 	if (!_updateVisibility)
 		return ;
+	_updateVisibility = false;
+	_chunkLoadList.clear();
+	_chunkGenerateList.clear();
+	_chunkMeshList.clear();
+	_chunkUploadList.clear();
 	_chunkVisibleList.clear();
+	_visibleChanged = true;
 	// Loop through all chunks, and unload all outisde of render distance
-	_chunksMtx.lock();
-	for (auto &[chunkCoord, chunk]: _chunks)
-	{
-		if (!chunk)
-			continue;
-		if (
-			(chunkCoord.x >= _renderMin.x && chunkCoord.y >= _renderMin.y)
-			&& (chunkCoord.x <= _renderMax.x && chunkCoord.y <= _renderMax.y)
-		)
-			continue ;
-		// Don't unload yet if chunk is in the task queue
+	_chunks.forEach([this](std::shared_ptr<Chunk> &chunk) {
+		// Chunks in the margin around render distance stay loaded, so moving back and forth over a chunk border doesn't unload them
+		if (_isInUnloadRange(chunk->getChunkPos()))
+			return ;
+		// Don't unload yet if chunk is in the task queue, it's dispatched again once its task is done
 		if (chunk->_busy == true)
-			continue ;
+			return ;
 		chunk->_busy = true;
 		_chunkUnloadList.push_back(chunk);
-	}
-	_chunksMtx.unlock();
+	});
 	// Loop through all chunk coordinates within render distance
 	// Starting at the camera chunk and expanding out from there
 	for (int dist = 0; dist <= _renderDistance; ++dist)
@@ -172,41 +181,142 @@ void	ChunkManager::_updateVisibleList()
 				if ((x != -dist && x != dist) && (y != -dist && y != dist))
 					y = dist;
 				const mlm::ivec2		chunkCoord = _cameraChunkCoord + mlm::ivec2(x, y);
-				_chunksMtx.lock();
-				std::shared_ptr<Chunk>	chunk = _chunks[chunkCoord];
-				_chunksMtx.unlock();
+				std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
 				// Load chunk if it isn't contained in the chunk map
 				if (chunk == nullptr)
 				{
 					_chunkLoadList.push_back(chunkCoord);
 					continue ;
 				}
-				// Place chunk in the correct list based on the current state
-				switch (chunk->getState())
-				{
-				case Chunk::LOADED:
-					_chunkGenerateList.push_back(chunk);
-					break ;
-				case Chunk::GENERATED:
-					_chunkMeshList.push_back(chunk);
-					break ;
-				case Chunk::MESHED:
-					_chunkUploadList.push_back(chunk);
-					break ;
-				case Chunk::UPLOADED:
-					_chunkVisibleList.push_back(chunk);
-					break ;
-				default:
-					break;
-				}
-				if (chunk->_dirty == true)
-					_chunkMeshList.push_back(chunk);
-				if (chunk->_readyToUpload == true)
-					_chunkUploadList.push_back(chunk);
+				_dispatchChunk(chunk);
 			}
 		}
 	}
-	_updateVisibility = false;
+}
+
+void	ChunkManager::_drainCompleted()
+{
+	std::vector<mlm::ivec2>	completed;
+	_completedMtx.lock();
+	completed.swap(_completed);
+	_completedMtx.unlock();
+	for (const mlm::ivec2 &chunkCoord : completed)
+	{
+		std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
+		if (chunk)
+			_onChunkChanged(chunk);
+	}
+}
+
+void	ChunkManager::_pushCompleted(const mlm::ivec2 &chunkCoord)
+{
+	_completedMtx.lock();
+	_completed.push_back(chunkCoord);
+	_completedMtx.unlock();
+}
+
+void	ChunkManager::_dispatchChunk(const std::shared_ptr<Chunk> &chunk)
+{
+	const mlm::ivec2	chunkCoord = chunk->getChunkPos();
+	if (_isInUnloadRange(chunkCoord) == false)
+	{
+		// Was busy when the camera left it behind
+		if (chunk->_busy == false)
+		{
+			chunk->_busy = true;
+			_chunkUnloadList.push_back(chunk);
+		}
+		return ;
+	}
+	if (_isInRenderRange(chunkCoord) == false)
+		return ;
+	// Like a chunk taken back from the unload cache with its mesh, duplicates are dropped when the visible list is sorted
+	if (chunk->getState() == Chunk::UPLOADED)
+	{
+		_chunkVisibleList.push_back(chunk);
+		_visibleChanged = true;
+	}
+	if (chunk->getState() == Chunk::LOADED && chunk->_busy == false)
+		_chunkGenerateList.push_back(chunk);
+	if (_isMeshReady(chunk))
+		_chunkMeshList.push_back(chunk);
+	if (chunk->_readyToUpload == true)
+		_chunkUploadList.push_back(chunk);
+}
+
+void	ChunkManager::_onChunkChanged(const std::shared_ptr<Chunk> &chunk)
+{
+	_dispatchChunk(chunk);
+	if (chunk->getState() < Chunk::GENERATED)
+		return ;
+	const mlm::ivec2	chunkCoord = chunk->getChunkPos();
+	_queueMeshIfReady(chunkCoord + mlm::ivec2(0, 1));
+	_queueMeshIfReady(chunkCoord + mlm::ivec2(0, -1));
+	_queueMeshIfReady(chunkCoord + mlm::ivec2(1, 0));
+	_queueMeshIfReady(chunkCoord + mlm::ivec2(-1, 0));
+}
+
+bool	ChunkManager::_isMeshReady(const std::shared_ptr<Chunk> &chunk)
+{
+	static const std::vector<mlm::ivec2>	neighbors = {
+		mlm::ivec2(0, 1),
+		mlm::ivec2(0, -1),
+		mlm::ivec2(1, 0),
+		mlm::ivec2(-1, 0),
+	};
+	// Is chunk valid target for meshing
+	if (!chunk || chunk->_busy == true || chunk->getState() < Chunk::GENERATED
+		|| (chunk->getState() != Chunk::GENERATED && chunk->_dirty == false))
+		return (false);
+	const mlm::ivec2	chunkCoord = chunk->getChunkPos();
+	if (_chunks.get(chunkCoord) != chunk || _isInRenderRange(chunkCoord) == false)
+		return (false);
+	// Check whether all neighboring chunks are generated before meshing
+	for (const mlm::ivec2 &neighbor : neighbors)
+	{
+		std::shared_ptr<Chunk>	chunkNeighbor = _chunks.get(chunkCoord - neighbor);
+		if (!chunkNeighbor || chunkNeighbor->getState() < Chunk::GENERATED)
+			return (false);
+	}
+	return (true);
+}
+
+void	ChunkManager::_queueMeshIfReady(const mlm::ivec2 &chunkCoord)
+{
+	std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
+	if (_isMeshReady(chunk))
+		_chunkMeshList.push_back(chunk);
+}
+
+bool	ChunkManager::_isInRenderRange(const mlm::ivec2 &chunkCoord) const
+{
+	return (chunkCoord.x >= _renderMin.x && chunkCoord.y >= _renderMin.y && chunkCoord.x <= _renderMax.x && chunkCoord.y <= _renderMax.y);
+}
+
+bool	ChunkManager::_isInUnloadRange(const mlm::ivec2 &chunkCoord) const
+{
+	return (chunkCoord.x >= _unloadMin.x && chunkCoord.y >= _unloadMin.y && chunkCoord.x <= _unloadMax.x && chunkCoord.y <= _unloadMax.y);
+}
+
+// Drops chunks that are no longer uploaded or loaded, and sorts the rest from near to far
+void	ChunkManager::_sortVisibleList()
+{
+	if (_visibleChanged == false)
+		return ;
+	_visibleChanged = false;
+	std::erase_if(_chunkVisibleList, [this](const std::shared_ptr<Chunk> &chunk) {
+		return (chunk->getState() != Chunk::UPLOADED || _chunks.get(chunk->getChunkPos()) != chunk || _isInRenderRange(chunk->getChunkPos()) == false);
+	});
+	auto	distance = [this](const std::shared_ptr<Chunk> &chunk) {
+		mlm::ivec2	offset = chunk->getChunkPos() - _cameraChunkCoord;
+		return (offset.x * offset.x + offset.y * offset.y);
+	};
+	std::sort(_chunkVisibleList.begin(), _chunkVisibleList.end(), [&distance](const std::shared_ptr<Chunk> &a, const std::shared_ptr<Chunk> &b) {
+		int	distanceA = distance(a);
+		int	distanceB = distance(b);
+		return (distanceA < distanceB || (distanceA == distanceB && a < b));
+	});
+	_chunkVisibleList.erase(std::unique(_chunkVisibleList.begin(), _chunkVisibleList.end()), _chunkVisibleList.end());
 }
 
 void	ChunkManager::_updateRenderList()
@@ -251,6 +361,14 @@ void	ChunkManager::_updateCameraChunkCoord()
 	// Check if the camera entered a new chunk
 	if (cameraChunkCoord != _cameraChunkCoord)
 	{
+		// Moving more than 1 chunk at once counts as a jump, like the first frame or a teleport
+		int64_t	jumpX = std::abs(static_cast<int64_t>(cameraChunkCoord.x) - _cameraChunkCoord.x);
+		int64_t	jumpZ = std::abs(static_cast<int64_t>(cameraChunkCoord.y) - _cameraChunkCoord.y);
+		if (jumpX > 1 || jumpZ > 1)
+		{
+			_waitingForTerrain = true;
+			_jumpTime = std::chrono::steady_clock::now();
+		}
 		_cameraChunkCoord = cameraChunkCoord;
 
 		// Update chunk visibility lists
@@ -258,5 +376,22 @@ void	ChunkManager::_updateCameraChunkCoord()
 		// Set the new min and max rendered chunk coordinates
 		_renderMin = _cameraChunkCoord - mlm::ivec2(_renderDistance);
 		_renderMax = _cameraChunkCoord + mlm::ivec2(_renderDistance);
+		_unloadMin = _renderMin - mlm::ivec2(_unloadMargin);
+		_unloadMax = _renderMax + mlm::ivec2(_unloadMargin);
+		_reprioritizeTasks();
 	}
 }
+
+// Logs how long it took for the chunk the camera jumped to to be uploaded
+void	ChunkManager::_updateTimeToVisible()
+{
+	if (_waitingForTerrain == false)
+		return ;
+	std::shared_ptr<Chunk>	chunk = _chunks.get(_cameraChunkCoord);
+	bool					visible = chunk && chunk->getState() == Chunk::UPLOADED;
+	if (visible == false)
+		return ;
+	_waitingForTerrain = false;
+	float	ms = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - _jumpTime).count();
+	Logger::log("Terrain visible " + std::to_string(ms) + " ms after jumping to chunk " + std::to_string(_cameraChunkCoord.x) + ", " + std::to_string(_cameraChunkCoord.y));
+}
@@ -4,10 +4,13 @@ Created on: 10/03/2026
 */
 
 #include "ChunkManager.hpp"
+#include "BlockPool.hpp"
 #include "Coords.hpp"
 #include "Settings.hpp"
 #include "Logger.hpp"
 
+#include <algorithm>
+
 // Check weather the y coordinate is in valid range
 static bool	checkValidYCoordinate(const float y)
 {
@@ -16,9 +19,12 @@ static bool	checkValidYCoordinate(const float y)
 
 void	ChunkManager::unloadAll()
 {
-	_chunksMtx.lock();
+	_stopSaving();
 	Logger::info("Clearing chunks");
+	// Tasks are found by chunk coordinate, they can't be left for the chunks that get loaded next
+	_cancelTasks();
 	_chunks.clear();
+	_clearUnloadCache();
 	try
 	{
 		Logger::info("Loading terrain generator");
@@ -30,7 +36,15 @@ void	ChunkManager::unloadAll()
 	{
 		Logger::error(e.what());
 	}
-	_chunksMtx.unlock();
+	// The seed might have changed
+	try
+	{
+		_startSaving();
+	}
+	catch(const std::exception& e)
+	{
+		Logger::error(e.what());
+	}
 	_updateVisibility = true;
 }
 
@@ -44,9 +58,7 @@ Expected<Block, int>	ChunkManager::getBlock(const mlm::ivec3 &blockCoord)
 	if (checkValidYCoordinate(blockCoord.y))
 		return (1);
 	mlm::ivec2				chunkCoord = getChunkCoord(blockCoord);
-	_chunksMtx.lock();
-	std::shared_ptr<Chunk>	chunk = _chunks[chunkCoord];
-	_chunksMtx.unlock();
+	std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
 	if (!chunk)
 		return (0);
 	mlm::ivec3				blockChunkCoord = getBlockChunkCoord(blockCoord);
@@ -54,6 +66,28 @@ Expected<Block, int>	ChunkManager::getBlock(const mlm::ivec3 &blockCoord)
 	return (block);
 }
 
+// Returns nullptr if the chunk isn't loaded
+ChunkSnapshotPtr	ChunkManager::getChunkSnapshot(const mlm::ivec2 &chunkCoord)
+{
+	std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
+	if (!chunk)
+		return (nullptr);
+	return (chunk->getSnapshot());
+}
+
+// Returns nullptr if the chunk isn't loaded
+std::shared_ptr<Chunk>	ChunkManager::getChunk(const mlm::ivec2 &chunkCoord)
+{
+	return (_chunks.get(chunkCoord));
+}
+
+bool	ChunkManager::isChunkVisible(const mlm::ivec2 &chunkCoord) const
+{
+	return (std::any_of(_chunkVisibleList.begin(), _chunkVisibleList.end(), [&chunkCoord](const std::shared_ptr<Chunk> &chunk) {
+		return (chunk->getChunkPos() == chunkCoord);
+	}));
+}
+
 void	ChunkManager::setBlock(const mlm::vec3 &blockCoord, Block block)
 {
 	setBlock(getWorldCoord(blockCoord), block);
@@ -64,45 +98,28 @@ void	ChunkManager::setBlock(const mlm::ivec3 &blockCoord, Block block)
 	if (checkValidYCoordinate(blockCoord.y))
 		return ;
 	mlm::ivec2				chunkCoord = getChunkCoord(blockCoord);
-	_chunksMtx.lock();
-	std::shared_ptr<Chunk>	chunk = _chunks[chunkCoord];
-	_chunksMtx.unlock();
+	std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
 	if (!chunk)
 		return ;
 	mlm::ivec3				blockChunkCoord = getBlockChunkCoord(blockCoord);
 
+	// Also records the edit in the journal
 	bool updated = chunk->setBlock(blockChunkCoord, block);
 	if (updated == false)
 		return ;
 
-	// If on chunk boundary -> set neighbor dirty flag for remeshing
+	// If on chunk boundary -> set neighbor dirty flag for remeshing, cached neighbors included
 	if (blockChunkCoord.x == 0)
-	{
-		_chunksMtx.lock();
-		_chunks[chunkCoord + mlm::ivec2(-1, 0)]->_dirty = true;
-		_chunksMtx.unlock();
-	}
+		_markDirty(chunkCoord + mlm::ivec2(-1, 0));
 	if (blockChunkCoord.z == 0)
-	{
-		_chunksMtx.lock();
-		_chunks[chunkCoord + mlm::ivec2(0, -1)]->_dirty = true;
-		_chunksMtx.unlock();
-	}
+		_markDirty(chunkCoord + mlm::ivec2(0, -1));
 	if (blockChunkCoord.x == CHUNK_SIZE_X - 1)
-	{
-		_chunksMtx.lock();
-		_chunks[chunkCoord + mlm::ivec2(1, 0)]->_dirty = true;
-		_chunksMtx.unlock();
-	}
+		_markDirty(chunkCoord + mlm::ivec2(1, 0));
 	if (blockChunkCoord.z == CHUNK_SIZE_Z - 1)
-	{
-		_chunksMtx.lock();
-		_chunks[chunkCoord + mlm::ivec2(0, 1)]->_dirty = true;
-		_chunksMtx.unlock();
-	}
+		_markDirty(chunkCoord + mlm::ivec2(0, 1));
 	// Set chunk dirty flag for remeshing
 	chunk->_dirty = true;
-	_updateVisibility = true;
+	_dispatchChunk(chunk);
 }
 
 Expected<Block::Type, int>	ChunkManager::getBlockType(const mlm::vec3 &blockCoord)
@@ -117,9 +134,7 @@ Expected<Block::Type, int>	ChunkManager::getBlockType(const mlm::ivec3 &blockCoo
 
 	// Fetch chunk
 	mlm::ivec2				chunkCoord = getChunkCoord(blockCoord);
-	_chunksMtx.lock();
-	std::shared_ptr<Chunk>	chunk = _chunks[chunkCoord];
-	_chunksMtx.unlock();
+	std::shared_ptr<Chunk>	chunk = _chunks.get(chunkCoord);
 	if (!chunk)
 		return (0);
 
@@ -212,7 +227,103 @@ void	ChunkManager::setUpdateVisibility()
 	_updateVisibility = true;
 }
 
+bool	ChunkManager::getGreedyMeshing() const
+{
+	return (_greedyMeshing);
+}
+
+bool	ChunkManager::getFreeMeshVertices() const
+{
+	return (_freeMeshVertices);
+}
+
+void	ChunkManager::setGreedyMeshing(bool greedyMeshing)
+{
+	_greedyMeshing = greedyMeshing;
+}
+
+void	ChunkManager::addMeshStats(uint64_t faceCount, uint64_t quadCount, uint64_t microseconds)
+{
+	_meshedFaces += faceCount;
+	_meshedQuads += quadCount;
+	_meshedChunks++;
+	_meshMicroseconds += microseconds;
+}
+
+void	ChunkManager::logMeshStats()
+{
+	uint64_t	faces = _meshedFaces;
+	uint64_t	quads = _meshedQuads;
+	// Only log when something has been meshed since the last time
+	if (quads == _loggedQuads || faces == 0)
+		return ;
+	_loggedQuads = quads;
+	float		ratio = static_cast<float>(quads) / static_cast<float>(faces) * 100.0f;
+	float		meshTime = static_cast<float>(_meshMicroseconds) / static_cast<float>(_meshedChunks) / 1000.0f;
+	Logger::log("Meshing: " + std::to_string(faces) + " faces -> " + std::to_string(quads) + " quads (" + std::to_string(quads * 4) + " vertices, " + std::to_string(ratio) + "% of per-face meshing), " + std::to_string(meshTime) + " ms per chunk");
+}
+
+void	ChunkManager::logMemoryStats()
+{
+	uint64_t	bytes = 0;
+	size_t		chunkCount = 0;
+	// Chunks still waiting to be generated or read have no blocks yet and would lower the average
+	_chunks.forEach([&bytes, &chunkCount](std::shared_ptr<Chunk> &chunk) {
+		if (!chunk || chunk->getState() < Chunk::GENERATED)
+			return ;
+		bytes += chunk->getBlockMemory();
+		chunkCount++;
+	});
+	// Only log when the amount of loaded chunks has changed
+	if (chunkCount == _loggedChunks || chunkCount == 0)
+		return ;
+	_loggedChunks = chunkCount;
+	Logger::log("Blocks: " + std::to_string(chunkCount) + " chunks, " + std::to_string(bytes / chunkCount / 1024) + " KiB per chunk, " + std::to_string(bytes / (1024 * 1024)) + " MiB total");
+	ChunkPool::Stats	chunkStats = _chunkPool.getStats();
+	BlockPool::Stats	blockStats = BlockPool::getStats();
+	Logger::log("Pools: " + std::to_string(chunkStats.hits) + " chunks reused, " + std::to_string(chunkStats.misses) + " allocated, "
+		+ std::to_string(chunkStats.pooledChunks) + " pooled (" + std::to_string(chunkStats.residentBytes / (1024 * 1024)) + " MiB), "
+		+ std::to_string(blockStats.hits) + " block arrays reused, " + std::to_string(blockStats.misses) + " allocated ("
+		+ std::to_string(blockStats.residentBytes / (1024 * 1024)) + " MiB resident)");
+}
+
+void	ChunkManager::logCacheStats()
+{
+	// Only log when a chunk came back from a cache since the last time
+	if (_cacheStats.hits != _loggedHits)
+	{
+		_loggedHits = _cacheStats.hits;
+		float	hitRate = static_cast<float>(_cacheStats.hits) / static_cast<float>(_cacheStats.hits + _cacheStats.misses) * 100.0f;
+		Logger::log("Unload cache: " + std::to_string(_unloadedChunks.size()) + " chunks, " + std::to_string(hitRate) + "% hit rate, "
+			+ std::to_string(_cacheStats.regenerationsAvoided) + " regenerations and " + std::to_string(_cacheStats.remeshesAvoided) + " remeshes avoided");
+	}
+	MeshCache::Stats	meshStats = _meshCache.getStats();
+	if (meshStats.hits != _loggedMeshHits)
+	{
+		_loggedMeshHits = meshStats.hits;
+		float	hitRate = static_cast<float>(meshStats.hits) / static_cast<float>(meshStats.hits + meshStats.misses) * 100.0f;
+		Logger::log("Mesh cache: " + std::to_string(_meshCache.getBytes() / (1024 * 1024)) + " MiB, " + std::to_string(_meshCache.getSpillBytes() / (1024 * 1024))
+			+ " MiB on disk, " + std::to_string(hitRate) + "% hit rate (" + std::to_string(meshStats.spillHits) + " from disk, "
+			+ std::to_string(meshStats.collisions) + " collisions), " + std::to_string(meshStats.microsecondsSaved / 1000) + " ms of meshing saved");
+	}
+}
+
+ChunkCacheStats	ChunkManager::getCacheStats() const
+{
+	return (_cacheStats);
+}
+
 VoxEngine	&ChunkManager::getEngine()
 {
 	return (_engine);
 }
+
+MeshCache	&ChunkManager::getMeshCache()
+{
+	return (_meshCache);
+}
+
+EditJournal	&ChunkManager::getEditJournal()
+{
+	return (_journal);
+}
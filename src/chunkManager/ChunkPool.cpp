@@ -0,0 +1,104 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "ChunkPool.hpp"
+#include "Chunk.hpp"
+
+ChunkPool::ChunkPool(): _shared(std::make_shared<Shared>())
+{}
+
+ChunkPool::~ChunkPool()
+{}
+
+void	ChunkPool::init(size_t highWater)
+{
+	std::lock_guard<std::mutex>	lock(_shared->mtx);
+	_shared->highWater = highWater;
+}
+
+std::shared_ptr<Chunk>	ChunkPool::acquire(const mlm::ivec2 &chunkPos, ChunkManager &manager)
+{
+	collect();
+	std::unique_ptr<Chunk>	chunk;
+	_shared->mtx.lock();
+	if (!_shared->free.empty())
+	{
+		chunk = std::move(_shared->free.back());
+		_shared->free.pop_back();
+	}
+	_shared->mtx.unlock();
+
+	if (chunk)
+	{
+		chunk->reset(chunkPos);
+		_hits++;
+	}
+	else
+	{
+		chunk = std::make_unique<Chunk>(chunkPos, manager);
+		_misses++;
+	}
+	std::weak_ptr<Shared>	weak = _shared;
+	return (std::shared_ptr<Chunk>(chunk.release(), [weak](Chunk *released) {
+		std::shared_ptr<Shared>	shared = weak.lock();
+		// The pool outlives the workers, so without it this is the main thread shutting down
+		if (!shared)
+		{
+			delete released;
+			return ;
+		}
+		// Can run on a worker, so no GL here. The blocks aren't needed anymore and go back to the BlockPool now
+		released->releaseBlocks();
+		std::lock_guard<std::mutex>	lock(shared->mtx);
+		shared->released.emplace_back(released);
+	}));
+}
+
+void	ChunkPool::collect()
+{
+	std::vector<std::unique_ptr<Chunk>>	released;
+	_shared->mtx.lock();
+	released.swap(_shared->released);
+	_shared->mtx.unlock();
+	if (released.empty())
+		return ;
+
+	for (std::unique_ptr<Chunk> &chunk : released)
+		chunk->releaseGpu();
+	std::lock_guard<std::mutex>	lock(_shared->mtx);
+	for (std::unique_ptr<Chunk> &chunk : released)
+	{
+		if (_shared->free.size() >= _shared->highWater)
+			break ;
+		_shared->free.push_back(std::move(chunk));
+	}
+	// The ones that didn't fit are deleted when released goes out of scope
+}
+
+void	ChunkPool::clear()
+{
+	collect();
+	std::vector<std::unique_ptr<Chunk>>	free;
+	_shared->mtx.lock();
+	free.swap(_shared->free);
+	_shared->mtx.unlock();
+}
+
+ChunkPool::Stats	ChunkPool::getStats() const
+{
+	std::lock_guard<std::mutex>	lock(_shared->mtx);
+	Stats						stats = {_hits, _misses, _shared->free.size() + _shared->released.size(), 0};
+	for (const std::unique_ptr<Chunk> &chunk : _shared->free)
+		stats.residentBytes += _residentBytes(*chunk);
+	for (const std::unique_ptr<Chunk> &chunk : _shared->released)
+		stats.residentBytes += _residentBytes(*chunk);
+	return (stats);
+}
+
+// The blocks were dropped when the chunk was released, it only shares the empty snapshot
+size_t	ChunkPool::_residentBytes(Chunk &chunk)
+{
+	return (sizeof(Chunk) + chunk.getVertexCapacity() * sizeof(ChunkVertex) + chunk.getGpuMemory());
+}
@@ -0,0 +1,341 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "ChunkStorage.hpp"
+#include "Chunk.hpp"
+#include "Logger.hpp"
+
+#include <algorithm>
+#include <filesystem>
+
+ChunkStorage::ChunkStorage()
+{}
+
+ChunkStorage::~ChunkStorage()
+{
+	stop();
+}
+
+void	ChunkStorage::start(const std::string &path, bool mmapReads)
+{
+	_path = path;
+	_mmapReads = mmapReads;
+	std::filesystem::create_directories(_path);
+	_running = true;
+	_thread = std::thread(&ChunkStorage::_routine, this);
+}
+
+void	ChunkStorage::stop()
+{
+	_queueMtx.lock();
+	_running = false;
+	_queueMtx.unlock();
+	_wake.notify_all();
+	if (_thread.joinable())
+		_thread.join();
+	std::vector<ReadRequest>	dropped;
+	_queueMtx.lock();
+	dropped.swap(_reads);
+	_queueMtx.unlock();
+	for (ReadRequest &request : dropped)
+		request.callback(nullptr);
+	_regionsMtx.lock();
+	_regions.clear();
+	_regionsMtx.unlock();
+}
+
+bool	ChunkStorage::isRunning() const
+{
+	return (_running);
+}
+
+// Never opens a region file, that is left to the I/O thread
+bool	ChunkStorage::mayContain(const mlm::ivec2 &chunkPos)
+{
+	if (!_running)
+		return (false);
+	_queueMtx.lock();
+	bool	pending = _writes.contains(_key(chunkPos)) || _writing.contains(_key(chunkPos));
+	_queueMtx.unlock();
+	if (pending)
+		return (true);
+	RegionFile	*region = _findRegion(chunkPos);
+	return (!region || region->contains(chunkPos));
+}
+
+// Chunks that are still waiting to be written don't have to go through the file, they are still answered on the I/O thread
+void	ChunkStorage::read(const mlm::ivec2 &chunkPos, ReadCallback callback)
+{
+	ChunkSnapshotPtr	snapshot = nullptr;
+	_queueMtx.lock();
+	if (auto it = _writes.find(_key(chunkPos)); it != _writes.end())
+		snapshot = it->second.second;
+	else if (auto it = _writing.find(_key(chunkPos)); it != _writing.end())
+		snapshot = it->second.second;
+	_reads.push_back({chunkPos, std::move(callback), std::move(snapshot)});
+	_queueMtx.unlock();
+	_wake.notify_one();
+}
+
+void	ChunkStorage::write(const mlm::ivec2 &chunkPos, ChunkSnapshotPtr snapshot)
+{
+	if (!_running || !snapshot)
+		return ;
+	_queueMtx.lock();
+	_writes[_key(chunkPos)] = {chunkPos, std::move(snapshot)};
+	_queueMtx.unlock();
+	_wake.notify_one();
+}
+
+void	ChunkStorage::flush()
+{
+	std::unique_lock<std::mutex>	lock(_queueMtx);
+	_flushed.wait(lock, [this]() {return ((_writes.empty() && _writing.empty()) || !_running);});
+}
+
+uint64_t	ChunkStorage::getReadCount() const
+{
+	return (_readCount);
+}
+
+uint64_t	ChunkStorage::getWriteCount() const
+{
+	return (_writeCount);
+}
+
+uint64_t	ChunkStorage::getWrittenBytes() const
+{
+	return (_writtenBytes);
+}
+
+/*
+// Every column of the chunk, z major like TerrainGenerator::getColumns, is stored bottom to top
+// as runs of a type byte followed by the run length minus 1
+*/
+std::vector<uint8_t>	ChunkStorage::encode(const ChunkSnapshot &snapshot)
+{
+	static_assert(CHUNK_SIZE_Y <= 256, "Run lengths have to fit in a byte");
+	std::vector<uint8_t>	data;
+	data.reserve(CHUNK_SIZE_X * CHUNK_SIZE_Z * 8);
+	for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+	{
+		for (uint64_t x = 0; x < CHUNK_SIZE_X; ++x)
+		{
+			uint8_t		type = snapshot.sections[0]->getBlock(x, 0, z).getType();
+			uint64_t	length = 0;
+			for (const std::shared_ptr<const ChunkSection> &section : snapshot.sections)
+			{
+				// A uniform section adds one run of SECTION_SIZE blocks to every column
+				uint64_t	step = section->isUniform() ? SECTION_SIZE : 1;
+				for (uint64_t y = 0; y < SECTION_SIZE; y += step)
+				{
+					uint8_t	next = section->getBlock(x, y, z).getType();
+					if (next != type)
+					{
+						data.push_back(type);
+						data.push_back(static_cast<uint8_t>(length - 1));
+						type = next;
+						length = 0;
+					}
+					length += step;
+				}
+			}
+			data.push_back(type);
+			data.push_back(static_cast<uint8_t>(length - 1));
+		}
+	}
+	return (data);
+}
+
+ChunkSnapshotPtr	ChunkStorage::decode(const uint8_t *data, size_t size)
+{
+	std::vector<uint8_t>	types(CHUNK_SIZE_X * CHUNK_SIZE_Z * CHUNK_SIZE_Y);
+	size_t					i = 0;
+	for (uint64_t column = 0; column < CHUNK_SIZE_X * CHUNK_SIZE_Z; ++column)
+	{
+		uint8_t		*columnTypes = &types[column * CHUNK_SIZE_Y];
+		uint64_t	y = 0;
+		while (y < CHUNK_SIZE_Y)
+		{
+			if (i + 2 > size || data[i] >= Block::TYPE_COUNT)
+				return (nullptr);
+			uint64_t	length = static_cast<uint64_t>(data[i + 1]) + 1;
+			if (y + length > CHUNK_SIZE_Y)
+				return (nullptr);
+			std::fill_n(columnTypes + y, length, data[i]);
+			y += length;
+			i += 2;
+		}
+	}
+	if (i != size)
+		return (nullptr);
+
+	std::shared_ptr<ChunkSnapshot>	snapshot = std::make_shared<ChunkSnapshot>();
+	for (uint64_t sectionY = 0; sectionY < CHUNK_SECTION_COUNT; ++sectionY)
+	{
+		uint64_t	baseY = sectionY * SECTION_SIZE;
+		uint8_t		first = types[baseY];
+		bool		uniform = true;
+		for (uint64_t column = 0; column < CHUNK_SIZE_X * CHUNK_SIZE_Z && uniform; ++column)
+		{
+			const uint8_t	*columnTypes = &types[column * CHUNK_SIZE_Y + baseY];
+			uniform = std::all_of(columnTypes, columnTypes + SECTION_SIZE, [first](uint8_t type) {return (type == first);});
+		}
+		std::shared_ptr<ChunkSection>	section = std::make_shared<ChunkSection>(Block(static_cast<Block::Type>(first)));
+		if (uniform == false)
+		{
+			for (uint64_t z = 0; z < CHUNK_SIZE_Z; ++z)
+			{
+				for (uint64_t x = 0; x < CHUNK_SIZE_X; ++x)
+				{
+					const uint8_t					*columnTypes = &types[(z * CHUNK_SIZE_X + x) * CHUNK_SIZE_Y + baseY];
+					std::array<Block, SECTION_SIZE>	blocks;
+					for (uint64_t y = 0; y < SECTION_SIZE; ++y)
+						blocks[y] = Block(static_cast<Block::Type>(columnTypes[y]));
+					section->setColumn(x, z, blocks.data());
+				}
+			}
+		}
+		snapshot->sections[sectionY] = std::move(section);
+	}
+	return (snapshot);
+}
+
+void	ChunkStorage::_routine()
+{
+	while (true)
+	{
+		std::vector<ReadRequest>		reads;
+		std::unique_lock<std::mutex>	lock(_queueMtx);
+		_wake.wait(lock, [this]() {return (!_reads.empty() || !_writes.empty() || !_running);});
+		// Queued writes still go to disk when stopping, so nothing that was unloaded gets lost
+		if (!_running && _writes.empty())
+			break ;
+		if (_running)
+			reads.swap(_reads);
+		_writing.swap(_writes);
+		lock.unlock();
+
+		_writeBatch();
+		lock.lock();
+		_writing.clear();
+		lock.unlock();
+		_flushed.notify_all();
+		_readBatch(reads);
+	}
+	_flushed.notify_all();
+}
+
+void	ChunkStorage::_readBatch(std::vector<ReadRequest> &reads)
+{
+	std::unordered_map<uint64_t, std::vector<mlm::ivec2>>	batches;
+	std::vector<bool>										done(reads.size(), false);
+	for (size_t i = 0; i < reads.size(); ++i)
+	{
+		if (reads[i].snapshot)
+		{
+			done[i] = true;
+			_readCount++;
+			reads[i].callback(reads[i].snapshot);
+		}
+		else
+			batches[_key(RegionFile::getRegionPos(reads[i].chunkPos))].push_back(reads[i].chunkPos);
+	}
+
+	for (const auto &[regionKey, chunkPositions] : batches)
+	{
+		RegionFile	&region = _getRegion(chunkPositions[0]);
+		try
+		{
+			region.read(chunkPositions, _mmapReads, [&](const mlm::ivec2 &chunkPos, const uint8_t *data, size_t size) {
+				ChunkSnapshotPtr	snapshot = decode(data, size);
+				if (!snapshot)
+				{
+					Logger::error("ChunkStorage: chunk " + std::to_string(chunkPos.x) + ", " + std::to_string(chunkPos.y) + " is corrupted, it will be generated again");
+					region.remove(chunkPos);
+				}
+				else
+					_readCount++;
+				for (size_t i = 0; i < reads.size(); ++i)
+				{
+					if (done[i] || reads[i].chunkPos != chunkPos)
+						continue ;
+					done[i] = true;
+					reads[i].callback(snapshot);
+				}
+			});
+		}
+		catch(const std::exception &e)
+		{
+			Logger::error("ChunkStorage: " + std::string(e.what()));
+		}
+	}
+	// Chunks that weren't in their region file after all
+	for (size_t i = 0; i < reads.size(); ++i)
+		if (!done[i])
+			reads[i].callback(nullptr);
+}
+
+void	ChunkStorage::_writeBatch()
+{
+	std::unordered_map<uint64_t, std::vector<std::pair<mlm::ivec2, std::vector<uint8_t>>>>	batches;
+	for (const auto &[key, write] : _writing)
+	{
+		const auto &[chunkPos, snapshot] = write;
+		batches[_key(RegionFile::getRegionPos(chunkPos))].push_back({chunkPos, encode(*snapshot)});
+	}
+	for (const auto &[regionKey, records] : batches)
+	{
+		try
+		{
+			_getRegion(records[0].first).write(records);
+			_writeCount += records.size();
+			for (const auto &record : records)
+				_writtenBytes += record.second.size();
+		}
+		catch(const std::exception &e)
+		{
+			Logger::error("ChunkStorage: " + std::string(e.what()));
+		}
+	}
+}
+
+RegionFile	*ChunkStorage::_findRegion(const mlm::ivec2 &chunkPos)
+{
+	std::lock_guard<std::mutex>	lock(_regionsMtx);
+	auto						it = _regions.find(_key(RegionFile::getRegionPos(chunkPos)));
+	if (it == _regions.end())
+		return (nullptr);
+	return (it->second.get());
+}
+
+// Opens the region file of a chunk the first time it's needed, a corrupted file is moved aside. Only called on the I/O thread
+RegionFile	&ChunkStorage::_getRegion(const mlm::ivec2 &chunkPos)
+{
+	mlm::ivec2					regionPos = RegionFile::getRegionPos(chunkPos);
+	std::lock_guard<std::mutex>	lock(_regionsMtx);
+	std::unique_ptr<RegionFile>	&region = _regions[_key(regionPos)];
+	if (region)
+		return (*region);
+	std::string	path = _path + "r." + std::to_string(regionPos.x) + "." + std::to_string(regionPos.y) + ".vox";
+	try
+	{
+		region = std::make_unique<RegionFile>(path);
+	}
+	catch(const std::exception &e)
+	{
+		Logger::error("ChunkStorage: " + std::string(e.what()) + ", moving it to " + path + ".corrupted");
+		std::error_code	error;
+		std::filesystem::rename(path, path + ".corrupted", error);
+		region = std::make_unique<RegionFile>(path);
+	}
+	return (*region);
+}
+
+// Same packing as ivec2Hash, which can't be included here
+uint64_t	ChunkStorage::_key(const mlm::ivec2 &pos)
+{
+	return (static_cast<uint32_t>(pos.x) | (static_cast<uint64_t>(static_cast<uint32_t>(pos.y)) << 32));
+}
@@ -0,0 +1,444 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "EditJournal.hpp"
+#include "Coords.hpp"
+#include "Logger.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(CHUNK_SIZE_X * CHUNK_SIZE_Y * CHUNK_SIZE_Z <= 65536, "Block indices have to fit in 16 bits");
+
+static std::runtime_error	fileError(const std::string &path, const std::string &what)
+{
+	return (std::runtime_error("EditJournal: " + path + ": " + what + ": " + std::strerror(errno)));
+}
+
+// Appends value to data as raw bytes
+template <typename T>
+static void	put(std::vector<uint8_t> &data, const T &value)
+{
+	size_t	size = data.size();
+	data.resize(size + sizeof(T));
+	std::memcpy(data.data() + size, &value, sizeof(T));
+}
+
+template <typename T>
+static T	get(const uint8_t *data)
+{
+	T	value;
+	std::memcpy(&value, data, sizeof(T));
+	return (value);
+}
+
+// Returns false if the file doesn't exist
+static bool	readFile(const std::string &path, std::vector<uint8_t> &data)
+{
+	int	fd = open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		if (errno == ENOENT)
+			return (false);
+		throw fileError(path, "open failed");
+	}
+	struct stat	info;
+	if (fstat(fd, &info) < 0)
+	{
+		close(fd);
+		throw fileError(path, "stat failed");
+	}
+	data.resize(info.st_size);
+	size_t	done = 0;
+	while (done < data.size())
+	{
+		ssize_t	count = read(fd, data.data() + done, data.size() - done);
+		if (count <= 0)
+		{
+			close(fd);
+			throw fileError(path, "read failed");
+		}
+		done += count;
+	}
+	close(fd);
+	return (true);
+}
+
+static void	writeAll(int fd, const std::string &path, const uint8_t *data, size_t size)
+{
+	while (size > 0)
+	{
+		ssize_t	count = write(fd, data, size);
+		if (count <= 0)
+			throw fileError(path, "write failed");
+		data += count;
+		size -= count;
+	}
+}
+
+// Makes the renames done in the directory at path survive a power loss
+static void	syncDirectory(const std::string &path)
+{
+	int	fd = open(path.c_str(), O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		throw fileError(path, "open failed");
+	if (fsync(fd) < 0)
+	{
+		int	error = errno;
+		close(fd);
+		errno = error;
+		throw fileError(path, "sync failed");
+	}
+	close(fd);
+}
+
+EditJournal::EditJournal()
+{}
+
+EditJournal::~EditJournal()
+{
+	stop();
+}
+
+void	EditJournal::start(const std::string &path)
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	_path = path;
+	_deltas.clear();
+	_editCount = 0;
+	std::filesystem::create_directories(_path);
+	_loadDeltas();
+	// Left behind by a compaction that didn't finish, its edits are older than the ones in the current journal
+	_replayJournal(_path + "edits.log.1");
+	_openJournal();
+	_running = true;
+	_compactRequested = std::filesystem::exists(_path + "edits.log.1");
+	_thread = std::thread(&EditJournal::_routine, this);
+	Logger::info("Loaded " + std::to_string(_editCount) + " edited blocks in " + std::to_string(_deltas.size()) + " chunks");
+}
+
+void	EditJournal::stop()
+{
+	_mtx.lock();
+	if (_running == false)
+	{
+		_mtx.unlock();
+		return ;
+	}
+	_running = false;
+	_mtx.unlock();
+	_wake.notify_all();
+	if (_thread.joinable())
+		_thread.join();
+	try
+	{
+		_compact();
+	}
+	catch(const std::exception &e)
+	{
+		Logger::error(e.what());
+	}
+	std::lock_guard<std::mutex>	lock(_mtx);
+	close(_journalFd);
+	_journalFd = -1;
+	_compactRequested = false;
+}
+
+bool	EditJournal::isRunning() const
+{
+	return (_running);
+}
+
+void	EditJournal::record(const mlm::ivec2 &chunkPos, const mlm::ivec3 &blockChunkCoord, Block block)
+{
+	if (_running == false)
+		return ;
+	uint16_t				index = static_cast<uint16_t>(index3D(blockChunkCoord));
+	std::vector<uint8_t>	record;
+	record.reserve(RECORD_SIZE);
+	put(record, static_cast<int32_t>(chunkPos.x));
+	put(record, static_cast<int32_t>(chunkPos.y));
+	put(record, index);
+	put(record, static_cast<uint8_t>(block.getType()));
+	put(record, _checksum(record.data(), record.size()));
+
+	std::lock_guard<std::mutex>	lock(_mtx);
+	_setDelta({chunkPos.x, chunkPos.y}, index, block.getType());
+	try
+	{
+		// One write per record, a killed process can't leave half of one behind
+		writeAll(_journalFd, _path + "edits.log", record.data(), record.size());
+		if (++_journalRecords >= COMPACT_RECORDS && _compactRequested == false)
+		{
+			_compactRequested = true;
+			_wake.notify_one();
+		}
+	}
+	catch(const std::exception &e)
+	{
+		Logger::error(e.what());
+	}
+}
+
+bool	EditJournal::apply(const mlm::ivec2 &chunkPos, ChunkSnapshot &snapshot) const
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	auto						it = _deltas.find({chunkPos.x, chunkPos.y});
+	if (it == _deltas.end())
+		return (false);
+
+	// Every edited section is copied once, the generated ones might be shared
+	std::array<std::shared_ptr<ChunkSection>, CHUNK_SECTION_COUNT>	edited;
+	for (const auto &[index, type] : it->second)
+	{
+		uint64_t	x = index % CHUNK_SIZE_X;
+		uint64_t	y = (index / CHUNK_SIZE_X) % CHUNK_SIZE_Y;
+		uint64_t	z = index / (CHUNK_SIZE_X * CHUNK_SIZE_Y);
+		uint64_t	sectionY = y / SECTION_SIZE;
+		if (!edited[sectionY])
+			edited[sectionY] = std::make_shared<ChunkSection>(*snapshot.sections[sectionY]);
+		edited[sectionY]->setBlock(x, y % SECTION_SIZE, z, Block(type));
+	}
+	for (uint64_t sectionY = 0; sectionY < CHUNK_SECTION_COUNT; ++sectionY)
+	{
+		if (!edited[sectionY])
+			continue ;
+		edited[sectionY]->compact();
+		snapshot.sections[sectionY] = std::move(edited[sectionY]);
+	}
+	return (true);
+}
+
+void	EditJournal::compact()
+{
+	if (_running)
+		_compact();
+}
+
+uint64_t	EditJournal::getEditCount() const
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	return (_editCount);
+}
+
+uint64_t	EditJournal::getChunkCount() const
+{
+	std::lock_guard<std::mutex>	lock(_mtx);
+	return (_deltas.size());
+}
+
+void	EditJournal::_setDelta(const ChunkKey &key, uint16_t index, Block::Type type)
+{
+	Deltas	&deltas = _deltas[key];
+	if (deltas.insert_or_assign(index, type).second)
+		_editCount++;
+}
+
+/*
+// Deltas file: magic, version, chunk count, then per chunk its x, z, block count and
+// the index and type of every block. Ends with the checksum of everything before it
+*/
+void	EditJournal::_loadDeltas()
+{
+	std::string				path = _path + "edits.dat";
+	std::vector<uint8_t>	data;
+	if (readFile(path, data) == false)
+		return ;
+	try
+	{
+		const size_t	headerSize = sizeof(DELTAS_MAGIC) + sizeof(VERSION) + sizeof(uint32_t);
+		if (data.size() < headerSize + sizeof(uint32_t)
+			|| _checksum(data.data(), data.size() - sizeof(uint32_t)) != get<uint32_t>(data.data() + data.size() - sizeof(uint32_t)))
+			throw std::runtime_error("checksum doesn't match");
+		if (std::memcmp(data.data(), DELTAS_MAGIC, sizeof(DELTAS_MAGIC)) != 0 || get<uint32_t>(data.data() + sizeof(DELTAS_MAGIC)) != VERSION)
+			throw std::runtime_error("not a version " + std::to_string(VERSION) + " deltas file");
+
+		size_t		end = data.size() - sizeof(uint32_t);
+		size_t		i = headerSize;
+		uint32_t	chunkCount = get<uint32_t>(data.data() + sizeof(DELTAS_MAGIC) + sizeof(VERSION));
+		for (uint32_t chunk = 0; chunk < chunkCount; ++chunk)
+		{
+			if (i + 12 > end)
+				throw std::runtime_error("chunk out of bounds");
+			ChunkKey	key = {get<int32_t>(data.data() + i), get<int32_t>(data.data() + i + 4)};
+			uint32_t	count = get<uint32_t>(data.data() + i + 8);
+			i += 12;
+			if (i + static_cast<uint64_t>(count) * 3 > end)
+				throw std::runtime_error("deltas out of bounds");
+			for (uint32_t delta = 0; delta < count; ++delta, i += 3)
+			{
+				if (data[i + 2] >= Block::TYPE_COUNT)
+					throw std::runtime_error("invalid block type");
+				_setDelta(key, get<uint16_t>(data.data() + i), static_cast<Block::Type>(data[i + 2]));
+			}
+		}
+		if (i != end)
+			throw std::runtime_error("trailing data");
+	}
+	catch(const std::exception &e)
+	{
+		// The journal can still hold the latest edits, the deltas file is kept for recovery
+		Logger::error("EditJournal: " + path + ": " + e.what() + ", moving it to " + path + ".corrupted");
+		_deltas.clear();
+		_editCount = 0;
+		std::error_code	error;
+		std::filesystem::rename(path, path + ".corrupted", error);
+	}
+}
+
+// Replays every complete record up to the first torn or corrupted one, returns where that one starts or 0 if path isn't a journal
+size_t	EditJournal::_replayJournal(const std::string &path)
+{
+	std::vector<uint8_t>	data;
+	size_t					end = 0;
+	if (readFile(path, data) && data.size() >= HEADER_SIZE
+		&& std::memcmp(data.data(), JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) == 0 && get<uint32_t>(data.data() + sizeof(JOURNAL_MAGIC)) == VERSION)
+	{
+		end = HEADER_SIZE;
+		while (end + RECORD_SIZE <= data.size())
+		{
+			const uint8_t	*record = data.data() + end;
+			if (_checksum(record, RECORD_SIZE - 4) != get<uint32_t>(record + RECORD_SIZE - 4) || record[10] >= Block::TYPE_COUNT)
+				break ;
+			_setDelta({get<int32_t>(record), get<int32_t>(record + 4)}, get<uint16_t>(record + 8), static_cast<Block::Type>(record[10]));
+			end += RECORD_SIZE;
+		}
+		if (end != data.size())
+			Logger::error("EditJournal: " + path + ": skipping " + std::to_string(data.size() - end) + " bytes of torn records");
+	}
+	return (end);
+}
+
+// Replays the current journal and opens it for appending, the torn records at its end are cut off
+void	EditJournal::_openJournal()
+{
+	std::string	path = _path + "edits.log";
+	size_t		end = _replayJournal(path);
+	_journalFd = open(path.c_str(), O_RDWR | O_CREAT | O_APPEND, 0644);
+	if (_journalFd < 0)
+		throw fileError(path, "open failed");
+	if (ftruncate(_journalFd, end) < 0)
+		throw fileError(path, "truncate failed");
+	if (end == 0)
+	{
+		std::vector<uint8_t>	header;
+		put(header, JOURNAL_MAGIC);
+		put(header, VERSION);
+		writeAll(_journalFd, path, header.data(), header.size());
+	}
+	_journalRecords = (end > HEADER_SIZE) ? (end - HEADER_SIZE) / RECORD_SIZE : 0;
+}
+
+/*
+// Moves the journal to edits.log.1 and starts an empty one, edits made while compacting go to the new one.
+// A journal left from a compaction that failed isn't replaced, the current journal then stays as it is
+// and the next compaction moves it
+*/
+bool	EditJournal::_rotateJournal()
+{
+	std::string	path = _path + "edits.log";
+	if (std::filesystem::exists(path + ".1"))
+		return (false);
+	std::filesystem::rename(path, path + ".1");
+	close(_journalFd);
+	_journalFd = -1;
+	_openJournal();
+	return (true);
+}
+
+/*
+// The deltas are taken and the journal moved aside under the lock, writing them out happens without it.
+// The new deltas file is synced and renamed into place, and the directory synced, before the old journal
+// is removed. A crash in between replays edits that are already in the deltas, which sets the same blocks again
+*/
+void	EditJournal::_compact()
+{
+	std::lock_guard<std::mutex>	compactLock(_compactMtx);
+	std::vector<uint8_t>		data;
+	_mtx.lock();
+	try
+	{
+		_rotateJournal();
+	}
+	catch(...)
+	{
+		_mtx.unlock();
+		throw ;
+	}
+	put(data, DELTAS_MAGIC);
+	put(data, VERSION);
+	put(data, static_cast<uint32_t>(_deltas.size()));
+	for (const auto &[key, deltas] : _deltas)
+	{
+		put(data, key.first);
+		put(data, key.second);
+		put(data, static_cast<uint32_t>(deltas.size()));
+		for (const auto &[index, type] : deltas)
+		{
+			put(data, index);
+			put(data, static_cast<uint8_t>(type));
+		}
+	}
+	_mtx.unlock();
+	put(data, _checksum(data.data(), data.size()));
+
+	std::string	path = _path + "edits.dat";
+	std::string	tmpPath = path + ".tmp";
+	int			fd = open(tmpPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd < 0)
+		throw fileError(tmpPath, "open failed");
+	try
+	{
+		writeAll(fd, tmpPath, data.data(), data.size());
+		if (fdatasync(fd) < 0)
+			throw fileError(tmpPath, "sync failed");
+	}
+	catch(...)
+	{
+		close(fd);
+		throw ;
+	}
+	close(fd);
+	std::filesystem::rename(tmpPath, path);
+	// Otherwise the removed journal can survive a power loss while the new deltas don't
+	syncDirectory(_path);
+	std::filesystem::remove(_path + "edits.log.1");
+}
+
+void	EditJournal::_routine()
+{
+	std::unique_lock<std::mutex>	lock(_mtx);
+	while (true)
+	{
+		_wake.wait(lock, [this]() {return (_compactRequested || !_running);});
+		if (!_running)
+			break ;
+		_compactRequested = false;
+		lock.unlock();
+		try
+		{
+			_compact();
+		}
+		catch(const std::exception &e)
+		{
+			Logger::error(e.what());
+		}
+		lock.lock();
+	}
+}
+
+// FNV-1a
+uint32_t	EditJournal::_checksum(const uint8_t *data, size_t size)
+{
+	uint32_t	hash = 2166136261u;
+	for (size_t i = 0; i < size; ++i)
+		hash = (hash ^ data[i]) * 16777619u;
+	return (hash);
+}
@@ -0,0 +1,194 @@
+/*
+Created by: Emily (Em_iIy) Winnink
+Created on: 18/10/2026
+*/
+
+#include "RegionFile.hpp"
+
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+constexpr int	LOG2_REGION_SIZE = std::bit_width(static_cast<unsigned>(REGION_SIZE)) - 1;
+
+// Closes the file descriptor when it goes out of scope
+struct FileGuard {
+	int	fd;
+
+	~FileGuard()
+	{
+		if (fd >= 0)
+			close(fd);
+	}
+};
+
+static std::runtime_error	fileError(const std::string &path, const std::string &what)
+{
+	return (std::runtime_error("RegionFile: " + path + ": " + what + ": " + std::strerror(errno)));
+}
+
+// Reads or writes exactly size bytes at offset, pread and pwrite can stop early
+static void	readAll(int fd, const std::string &path, void *dst, size_t size, uint64_t offset)
+{
+	uint8_t	*bytes = static_cast<uint8_t *>(dst);
+	while (size > 0)
+	{
+		ssize_t	count = pread(fd, bytes, size, offset);
+		if (count <= 0)
+			throw fileError(path, "read failed");
+		bytes += count;
+		size -= count;
+		offset += count;
+	}
+}
+
+static void	writeAll(int fd, const std::string &path, const void *src, size_t size, uint64_t offset)
+{
+	const uint8_t	*bytes = static_cast<const uint8_t *>(src);
+	while (size > 0)
+	{
+		ssize_t	count = pwrite(fd, bytes, size, offset);
+		if (count <= 0)
+			throw fileError(path, "write failed");
+		bytes += count;
+		size -= count;
+		offset += count;
+	}
+}
+
+RegionFile::RegionFile(const std::string &path): _path(path)
+{
+	FileGuard	file = {open(_path.c_str(), O_RDONLY)};
+	if (file.fd < 0)
+	{
+		if (errno == ENOENT)
+			return ;
+		throw fileError(_path, "open failed");
+	}
+	struct stat	info;
+	if (fstat(file.fd, &info) < 0)
+		throw fileError(_path, "stat failed");
+	if (static_cast<uint64_t>(info.st_size) < HEADER_SIZE)
+		throw std::runtime_error("RegionFile: " + _path + ": file is smaller than its header");
+
+	char		magic[sizeof(MAGIC)];
+	uint32_t	version;
+	readAll(file.fd, _path, magic, sizeof(magic), 0);
+	readAll(file.fd, _path, &version, sizeof(version), sizeof(magic));
+	if (std::memcmp(magic, MAGIC, sizeof(MAGIC)) != 0 || version != VERSION)
+		throw std::runtime_error("RegionFile: " + _path + ": not a version " + std::to_string(VERSION) + " region file");
+	readAll(file.fd, _path, _entries.data(), sizeof(_entries), sizeof(magic) + sizeof(version));
+	_end = info.st_size;
+
+	// Entries pointing outside of the file are dropped, their chunks get generated again
+	for (Entry &entry : _entries)
+		if (entry.offset < HEADER_SIZE || entry.offset + static_cast<uint64_t>(entry.size) > _end)
+			entry = {};
+}
+
+RegionFile::~RegionFile()
+{}
+
+mlm::ivec2	RegionFile::getRegionPos(const mlm::ivec2 &chunkPos)
+{
+	return (mlm::ivec2(chunkPos.x >> LOG2_REGION_SIZE, chunkPos.y >> LOG2_REGION_SIZE));
+}
+
+uint64_t	RegionFile::_index(const mlm::ivec2 &chunkPos)
+{
+	uint64_t	x = chunkPos.x & (REGION_SIZE - 1);
+	uint64_t	z = chunkPos.y & (REGION_SIZE - 1);
+	return (z * REGION_SIZE + x);
+}
+
+bool	RegionFile::contains(const mlm::ivec2 &chunkPos) const
+{
+	std::lock_guard<std::mutex>	lock(_entriesMtx);
+	return (_entries[_index(chunkPos)].size > 0);
+}
+
+void	RegionFile::remove(const mlm::ivec2 &chunkPos)
+{
+	std::lock_guard<std::mutex>	lock(_entriesMtx);
+	_entries[_index(chunkPos)] = {};
+}
+
+void	RegionFile::read(const std::vector<mlm::ivec2> &chunkPositions, bool mmapReads, const ReadCallback &callback) const
+{
+	std::vector<std::pair<mlm::ivec2, Entry>>	entries;
+	uint64_t									end;
+	_entriesMtx.lock();
+	for (const mlm::ivec2 &chunkPos : chunkPositions)
+		if (_entries[_index(chunkPos)].size > 0)
+			entries.push_back({chunkPos, _entries[_index(chunkPos)]});
+	end = _end;
+	_entriesMtx.unlock();
+	if (entries.empty())
+		return ;
+
+	FileGuard	file = {open(_path.c_str(), O_RDONLY)};
+	if (file.fd < 0)
+		throw fileError(_path, "open failed");
+	if (mmapReads)
+	{
+		void	*mapped = mmap(nullptr, end, PROT_READ, MAP_PRIVATE, file.fd, 0);
+		if (mapped == MAP_FAILED)
+			throw fileError(_path, "mmap failed");
+		const uint8_t	*bytes = static_cast<const uint8_t *>(mapped);
+		try
+		{
+			for (const auto &[chunkPos, entry] : entries)
+				callback(chunkPos, bytes + entry.offset, entry.size);
+		}
+		catch(...)
+		{
+			munmap(mapped, end);
+			throw ;
+		}
+		munmap(mapped, end);
+		return ;
+	}
+	std::vector<uint8_t>	buffer;
+	for (const auto &[chunkPos, entry] : entries)
+	{
+		buffer.resize(entry.size);
+		readAll(file.fd, _path, buffer.data(), entry.size, entry.offset);
+		callback(chunkPos, buffer.data(), buffer.size());
+	}
+}
+
+void	RegionFile::write(const std::vector<std::pair<mlm::ivec2, std::vector<uint8_t>>> &records)
+{
+	FileGuard	file = {open(_path.c_str(), O_RDWR | O_CREAT, 0644)};
+	if (file.fd < 0)
+		throw fileError(_path, "open failed");
+
+	std::lock_guard<std::mutex>	lock(_entriesMtx);
+	std::array<Entry, REGION_CHUNKS>	entries = _entries;
+	std::vector<uint8_t>				data;
+	for (const auto &[chunkPos, record] : records)
+	{
+		uint64_t	offset = _end + data.size();
+		if (offset + record.size() > UINT32_MAX)
+			throw std::runtime_error("RegionFile: " + _path + ": file is full");
+		entries[_index(chunkPos)] = {static_cast<uint32_t>(offset), static_cast<uint32_t>(record.size())};
+		data.insert(data.end(), record.begin(), record.end());
+	}
+
+	std::vector<uint8_t>	header(HEADER_SIZE);
+	std::memcpy(header.data(), MAGIC, sizeof(MAGIC));
+	std::memcpy(header.data() + sizeof(MAGIC), &VERSION, sizeof(VERSION));
+	std::memcpy(header.data() + sizeof(MAGIC) + sizeof(VERSION), entries.data(), sizeof(entries));
+	writeAll(file.fd, _path, data.data(), data.size(), _end);
+	// Otherwise the header can reach the disk before the records it points to
+	if (fdatasync(file.fd) < 0)
+		throw fileError(_path, "sync failed");
+	writeAll(file.fd, _path, header.data(), header.size(), 0);
+	_entries = entries;
+	_end += data.size();
+}
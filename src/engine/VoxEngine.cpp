@@ -34,6 +34,9 @@ void	VoxEngine::_mainLoop()
 		{
 			float fps = 1.0f / ((glfwGetTime() - time) / static_cast<float>(frame));
 			Logger::log("FPS: " + std::to_string(fps));
+			_chunkManager.logMeshStats();
+			_chunkManager.logMemoryStats();
+			_chunkManager.logCacheStats();
 			time = glfwGetTime();
 			frame = 0;
 		}
@@ -77,6 +77,8 @@ void	VoxEngine::_initInput()
 	_input.addOnPressCallback(GLFW_KEY_ESCAPE, std::bind(glfwSetWindowShouldClose, get_window(), GLFW_TRUE));
 	_input.addOnPressCallback(GLFW_KEY_TAB, [this]() {_input.toggleWireFrame();});
 	_input.addOnPressCallback(GLFW_KEY_RIGHT_CONTROL, [this]() {_sky.togglePause();});
+	// Teleport far enough to need all new chunks, to measure how fast terrain shows up
+	_input.addOnPressCallback(GLFW_KEY_T, [this]() {_camera.setPos(_camera.getPos() + mlm::vec3(4096.0f, 0.0f, 0.0f));});
 
 	mlm::vec2	size = static_cast<mlm::vec2>(Window::get_size());
 	glfwSetCursorPos(Window::get_window(), size.x / 2.0f, size.y / 2.0f);
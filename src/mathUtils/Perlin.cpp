@@ -5,14 +5,263 @@ Created on: 08/08/2025
 
 #include "Perlin.hpp"
 
+#include <array>
 #include <cmath>
+#include <cstring>
+
+// 2D gradients point at one of 360 whole degree angles
+static const std::array<mlm::vec2, 360>	gradients2D = []() {
+	std::array<mlm::vec2, 360>	ret;
+	for (size_t i = 0; i < ret.size(); ++i)
+	{
+		float	angle = mlm::radians(static_cast<float>(i));
+		ret[i] = mlm::vec2(std::cos(angle), std::sin(angle));
+	}
+	return (ret);
+}();
+
+// 3D gradients use the top bits of both halves of the hash as theta and phi, each in GRADIENT_3D_STEPS steps
+constexpr uint64_t						GRADIENT_3D_BITS = 6;
+constexpr uint64_t						GRADIENT_3D_STEPS = 1ULL << GRADIENT_3D_BITS;
+static const std::array<mlm::vec3, GRADIENT_3D_STEPS * GRADIENT_3D_STEPS>	gradients3D = []() {
+	std::array<mlm::vec3, GRADIENT_3D_STEPS * GRADIENT_3D_STEPS>	ret;
+	for (uint64_t p = 0; p < GRADIENT_3D_STEPS; ++p)
+	{
+		for (uint64_t t = 0; t < GRADIENT_3D_STEPS; ++t)
+		{
+			// Use the middle of every step
+			float	theta = (static_cast<float>(t) + 0.5f) / static_cast<float>(GRADIENT_3D_STEPS) * 2.0f * M_PI;
+			float	phi = (static_cast<float>(p) + 0.5f) / static_cast<float>(GRADIENT_3D_STEPS) * M_PI;
+			ret[p * GRADIENT_3D_STEPS + t] = mlm::vec3(std::cos(theta) * std::sin(phi), std::sin(theta) * std::sin(phi), std::cos(phi));
+		}
+	}
+	return (ret);
+}();
+
+/*
+// Batch kernels. They work on LANES points at a time with GCC vector extensions and are built for AVX2,
+// getValues only uses them when the CPU supports it. Without AVX2 the 64 bit hash multiplies have to be
+// emulated, which made SSE4.2 kernels slower than the scalar loop, so that is the fallback.
+// Every step matches the scalar getValue, so both give bit-identical results
+*/
+#if defined(__x86_64__) && defined(__GNUC__) && !defined(__clang__)
+# define PERLIN_AVX2
+#endif
+
+#ifdef PERLIN_AVX2
+
+#define LANE_INLINE inline __attribute__((always_inline))
+
+constexpr size_t	LANES = 8;
+typedef float		floatLanes __attribute__((vector_size(LANES * sizeof(float))));
+typedef int32_t		intLanes __attribute__((vector_size(LANES * sizeof(int32_t))));
+typedef uint32_t	uintLanes __attribute__((vector_size(LANES * sizeof(uint32_t))));
+typedef int64_t		longLanes __attribute__((vector_size(LANES * sizeof(int64_t))));
+typedef uint64_t	hashLanes __attribute__((vector_size(LANES * sizeof(uint64_t))));
+
+// static_cast<int>(std::floor(x))
+static LANE_INLINE void	floorLanes(const floatLanes &x, intLanes &out)
+{
+	// Conversion truncates towards zero, step down where that rounded up
+	out = __builtin_convertvector(x, intLanes);
+	out += (__builtin_convertvector(out, floatLanes) > x);
+}
+
+static LANE_INLINE void	smoothStepLanes(const floatLanes &t, floatLanes &out)
+{
+	out = t * t * t * (t * (t * 6.0f - 15.0f) + 10.0f);
+}
+
+// std::lerp, smoothStep can round to slightly above 1 so the t > 1 case is needed as well
+static LANE_INLINE void	lerpLanes(const floatLanes &a, const floatLanes &b, const floatLanes &t, floatLanes &out)
+{
+	floatLanes	x = a + t * (b - a);
+	floatLanes	bounded = ((t > 1.0f) == (b > a)) ? ((b < x) ? x : b) : ((b > x) ? x : b);
+	floatLanes	ret = (t == 1.0f) ? b : bounded;
+	intLanes	signsDiffer = ((a <= 0.0f) & (b >= 0.0f)) | ((a >= 0.0f) & (b <= 0.0f));
+	out = signsDiffer ? t * b + (1.0f - t) * a : ret;
+}
+
+static LANE_INLINE void	mixLanes(hashLanes &hash)
+{
+	hash ^= (hash >> 33);
+	hash *= 0xFF51AFD7ED558CCDULL;
+	hash ^= (hash >> 33);
+	hash *= 0xC4CEB9FE1A85EC53ULL;
+	hash ^= (hash >> 33);
+}
+
+static LANE_INLINE void	toHashLanes(const intLanes &coord, hashLanes &out)
+{
+	// Sign extend like static_cast<uint64_t>(int) does
+	out = reinterpret_cast<hashLanes>(__builtin_convertvector(coord, longLanes));
+}
+
+static LANE_INLINE void	gradientLanes(uint64_t seed, const intLanes &x, const intLanes &y, floatLanes &outX, floatLanes &outY)
+{
+	hashLanes	hx, hy;
+	toHashLanes(x, hx);
+	toHashLanes(y, hy);
+	hashLanes	hash = seed ^ (hx * 0x9E3779B185EBCA87ULL) ^ (hy * 0xC2B2AE3D27D4EB4FULL);
+	mixLanes(hash);
+
+	// hash % 360 on 32 bit halves, there is no 64 bit vector multiply high to divide with
+	static_assert((1ULL << 32) % 360 == 256);
+	uintLanes	high = __builtin_convertvector(hash >> 32, uintLanes);
+	uintLanes	low = __builtin_convertvector(hash & 0xFFFFFFFFULL, uintLanes);
+	uintLanes	index = ((high % 360) * 256 + low % 360) % 360;
+	for (size_t i = 0; i < LANES; ++i)
+	{
+		outX[i] = gradients2D[index[i]].x;
+		outY[i] = gradients2D[index[i]].y;
+	}
+}
+
+// Dot product of the offset to a corner and the gradient of that corner
+static LANE_INLINE void	dotGradientLanes(uint64_t seed, const intLanes &x, const intLanes &y, const intLanes &z,
+	const floatLanes &dx, const floatLanes &dy, const floatLanes &dz, floatLanes &out)
+{
+	hashLanes	hx, hy, hz;
+	toHashLanes(x, hx);
+	toHashLanes(y, hy);
+	toHashLanes(z, hz);
+	hashLanes	hash = seed ^ (hx * 0x9E3779B185EBCA87ULL) ^ (hy * 0xC2B2AE3D27D4EB4FULL) ^ (hz * 0x165667B19E3779F9ULL);
+	mixLanes(hash);
+
+	hashLanes	index = (hash >> (64 - GRADIENT_3D_BITS)) * GRADIENT_3D_STEPS + ((hash & 0xFFFFFFFFULL) >> (32 - GRADIENT_3D_BITS));
+	floatLanes	gx, gy, gz;
+	for (size_t i = 0; i < LANES; ++i)
+	{
+		const mlm::vec3	&gradient = gradients3D[index[i]];
+		gx[i] = gradient.x;
+		gy[i] = gradient.y;
+		gz[i] = gradient.z;
+	}
+	out = dx * gx + dy * gy + dz * gz;
+}
+
+// Returns how many points it did, the rest is left for the scalar loop
+__attribute__((target("avx2")))
+static size_t	valuesAVX2(uint64_t seed, const float *xs, const float *ys, float *out, size_t count)
+{
+	size_t	i = 0;
+	for (; i + LANES <= count; i += LANES)
+	{
+		floatLanes	x, y;
+		std::memcpy(&x, xs + i, sizeof(x));
+		std::memcpy(&y, ys + i, sizeof(y));
+
+		// Same steps as getValue, for every lane at once
+		intLanes	x0, y0;
+		floorLanes(x, x0);
+		floorLanes(y, y0);
+		intLanes	x1 = x0 + 1;
+		intLanes	y1 = y0 + 1;
+
+		floatLanes	g00x, g00y, g01x, g01y, g10x, g10y, g11x, g11y;
+		gradientLanes(seed, x0, y0, g00x, g00y);
+		gradientLanes(seed, x0, y1, g01x, g01y);
+		gradientLanes(seed, x1, y0, g10x, g10y);
+		gradientLanes(seed, x1, y1, g11x, g11y);
+
+		floatLanes	dx0 = x - __builtin_convertvector(x0, floatLanes);
+		floatLanes	dx1 = x - __builtin_convertvector(x1, floatLanes);
+		floatLanes	dy0 = y - __builtin_convertvector(y0, floatLanes);
+		floatLanes	dy1 = y - __builtin_convertvector(y1, floatLanes);
+		floatLanes	d00 = dx0 * g00x + dy0 * g00y;
+		floatLanes	d01 = dx0 * g01x + dy1 * g01y;
+		floatLanes	d10 = dx1 * g10x + dy0 * g10y;
+		floatLanes	d11 = dx1 * g11x + dy1 * g11y;
+
+		floatLanes	sx, sy;
+		smoothStepLanes(dx0, sx);
+		smoothStepLanes(dy0, sy);
+
+		floatLanes	lerp0, lerp1, value;
+		lerpLanes(d00, d10, sx, lerp0);
+		lerpLanes(d01, d11, sx, lerp1);
+		lerpLanes(lerp0, lerp1, sy, value);
+		std::memcpy(out + i, &value, sizeof(value));
+	}
+	return (i);
+}
+
+__attribute__((target("avx2")))
+static size_t	valuesAVX2(uint64_t seed, const float *xs, const float *ys, const float *zs, float *out, size_t count)
+{
+	size_t	i = 0;
+	for (; i + LANES <= count; i += LANES)
+	{
+		floatLanes	x, y, z;
+		std::memcpy(&x, xs + i, sizeof(x));
+		std::memcpy(&y, ys + i, sizeof(y));
+		std::memcpy(&z, zs + i, sizeof(z));
+
+		// Same steps as getValue, for every lane at once
+		intLanes	x0, y0, z0;
+		floorLanes(x, x0);
+		floorLanes(y, y0);
+		floorLanes(z, z0);
+		intLanes	x1 = x0 + 1;
+		intLanes	y1 = y0 + 1;
+		intLanes	z1 = z0 + 1;
+
+		floatLanes	dx0 = x - __builtin_convertvector(x0, floatLanes);
+		floatLanes	dx1 = x - __builtin_convertvector(x1, floatLanes);
+		floatLanes	dy0 = y - __builtin_convertvector(y0, floatLanes);
+		floatLanes	dy1 = y - __builtin_convertvector(y1, floatLanes);
+		floatLanes	dz0 = z - __builtin_convertvector(z0, floatLanes);
+		floatLanes	dz1 = z - __builtin_convertvector(z1, floatLanes);
+
+		floatLanes	d000, d001, d010, d011, d100, d101, d110, d111;
+		dotGradientLanes(seed, x0, y0, z0, dx0, dy0, dz0, d000);
+		dotGradientLanes(seed, x0, y0, z1, dx0, dy0, dz1, d001);
+		dotGradientLanes(seed, x0, y1, z0, dx0, dy1, dz0, d010);
+		dotGradientLanes(seed, x0, y1, z1, dx0, dy1, dz1, d011);
+		dotGradientLanes(seed, x1, y0, z0, dx1, dy0, dz0, d100);
+		dotGradientLanes(seed, x1, y0, z1, dx1, dy0, dz1, d101);
+		dotGradientLanes(seed, x1, y1, z0, dx1, dy1, dz0, d110);
+		dotGradientLanes(seed, x1, y1, z1, dx1, dy1, dz1, d111);
+
+		floatLanes	sx, sy, sz;
+		smoothStepLanes(dx0, sx);
+		smoothStepLanes(dy0, sy);
+		smoothStepLanes(dz0, sz);
+
+		floatLanes	xLerp00, xLerp01, xLerp10, xLerp11, yLerp0, yLerp1, value;
+		lerpLanes(d000, d100, sx, xLerp00);
+		lerpLanes(d001, d101, sx, xLerp01);
+		lerpLanes(d010, d110, sx, xLerp10);
+		lerpLanes(d011, d111, sx, xLerp11);
+		lerpLanes(xLerp00, xLerp10, sy, yLerp0);
+		lerpLanes(xLerp01, xLerp11, sy, yLerp1);
+		lerpLanes(yLerp0, yLerp1, sz, value);
+		std::memcpy(out + i, &value, sizeof(value));
+	}
+	return (i);
+}
+
+static bool	useAVX2()
+{
+	static const bool	supported = __builtin_cpu_supports("avx2");
+	return (supported);
+}
+
+#endif
+
+Perlin::Perlin()
+{}
+
+Perlin::Perlin(uint64_t seed):
+	_seed(seed)
+{}
 
 void	Perlin::setSeed(uint64_t seed)
 {
 	_seed = seed;
 }
 
-float	Perlin::getValue(float x, float y)
+float	Perlin::getValue(float x, float y) const
 {
 	// Get the integer coordinates around the position
 	mlm::vec2	pos(x, y);
@@ -22,10 +271,10 @@ float	Perlin::getValue(float x, float y)
 	int			y1 = y0 + 1;
 
 	// Create pseudo random gradient vectors for each coordinate
-	mlm::vec2	g00 = _gradient(x0, y0);
-	mlm::vec2	g01 = _gradient(x0, y1);
-	mlm::vec2	g10 = _gradient(x1, y0);
-	mlm::vec2	g11 = _gradient(x1, y1);
+	const mlm::vec2	&g00 = _gradient(x0, y0);
+	const mlm::vec2	&g01 = _gradient(x0, y1);
+	const mlm::vec2	&g10 = _gradient(x1, y0);
+	const mlm::vec2	&g11 = _gradient(x1, y1);
 
 	// Find the dot product between position and all the gradient vectors
 	float		d00 = mlm::dot(pos - mlm::vec2(x0, y0), g00);
@@ -42,7 +291,7 @@ float	Perlin::getValue(float x, float y)
 	return (value);
 }
 
-float	Perlin::getValue(float x, float y, float z)
+float	Perlin::getValue(float x, float y, float z) const
 {
 	// Get the integer coordinates around the position
 	mlm::vec3	pos(x, y, z);
@@ -54,14 +303,14 @@ float	Perlin::getValue(float x, float y, float z)
 	int			z1 = z0 + 1;
 
 	// Create pseudo random gradient vectors for each coordinate
-	mlm::vec3	g000 = _gradient(x0, y0, z0);
-	mlm::vec3	g001 = _gradient(x0, y0, z1);
-	mlm::vec3	g010 = _gradient(x0, y1, z0);
-	mlm::vec3	g011 = _gradient(x0, y1, z1);
-	mlm::vec3	g100 = _gradient(x1, y0, z0);
-	mlm::vec3	g101 = _gradient(x1, y0, z1);
-	mlm::vec3	g110 = _gradient(x1, y1, z0);
-	mlm::vec3	g111 = _gradient(x1, y1, z1);
+	const mlm::vec3	&g000 = _gradient(x0, y0, z0);
+	const mlm::vec3	&g001 = _gradient(x0, y0, z1);
+	const mlm::vec3	&g010 = _gradient(x0, y1, z0);
+	const mlm::vec3	&g011 = _gradient(x0, y1, z1);
+	const mlm::vec3	&g100 = _gradient(x1, y0, z0);
+	const mlm::vec3	&g101 = _gradient(x1, y0, z1);
+	const mlm::vec3	&g110 = _gradient(x1, y1, z0);
+	const mlm::vec3	&g111 = _gradient(x1, y1, z1);
 
 	// Find the dot product between position and all the gradient vectors
 	float		d000 = mlm::dot(pos - mlm::vec3(x0, y0, z0), g000);
@@ -93,48 +342,44 @@ float	Perlin::getValue(float x, float y, float z)
 	return (value);
 }
 
-float	Perlin::_smoothStep(float t) const
+void	Perlin::getValues(const float *xs, const float *ys, float *out, size_t count) const
 {
-	return (t * t * t * (t * (t * 6 - 15) + 10));
+	size_t	i = 0;
+#ifdef PERLIN_AVX2
+	if (useAVX2())
+		i = valuesAVX2(_seed, xs, ys, out, count);
+#endif
+	for (; i < count; ++i)
+		out[i] = getValue(xs[i], ys[i]);
 }
 
-mlm::vec2	Perlin::_gradient(int x, int y)
+void	Perlin::getValues(const float *xs, const float *ys, const float *zs, float *out, size_t count) const
 {
-	uint64_t	hash = _hash(x, y);
-
-	// Check if the hash has already been cached
-	auto		it = _2dGradients.find(hash);
-	if (it != _2dGradients.end())
-		return (it->second);
+	size_t	i = 0;
+#ifdef PERLIN_AVX2
+	if (useAVX2())
+		i = valuesAVX2(_seed, xs, ys, zs, out, count);
+#endif
+	for (; i < count; ++i)
+		out[i] = getValue(xs[i], ys[i], zs[i]);
+}
 
-	// Construct vector based on angle from hash
-	float		angle = mlm::radians(static_cast<float>(hash % 360));
-	mlm::vec2	ret(std::cos(angle), std::sin(angle));
+float	Perlin::_smoothStep(float t) const
+{
+	return (t * t * t * (t * (t * 6 - 15) + 10));
+}
 
-	// Cache the constructed vector
-	_2dGradients[hash] = ret;
-	return (ret);
+const mlm::vec2	&Perlin::_gradient(int x, int y) const
+{
+	return (gradients2D[_hash(x, y) % gradients2D.size()]);
 }
 
-mlm::vec3	Perlin::_gradient(int x, int y, int z)
+const mlm::vec3	&Perlin::_gradient(int x, int y, int z) const
 {
 	uint64_t	hash = _hash(x, y, z);
-
-	// Check if the hash has already been cached
-	auto		it = _3dGradients.find(hash);
-	if (it != _3dGradients.end())
-		return (it->second);
-
-	// Create 2 angles to have access to 3 dimensions
-	float theta = static_cast<float>(hash & 0xFFFFFFFFULL) / static_cast<float>(0xFFFFFFFFULL) * 2.0f * M_PI;
-	float phi   = static_cast<float>(hash >> 32) / static_cast<float>(0xFFFFFFFFULL) * M_PI;
-
-	// Construct vector based on angles from hash
-	mlm::vec3	ret(std::cos(theta) * std::sin(phi), std::sin(theta) * std::sin(phi), std::cos(phi));
-
-	// Cache the constructed vector
-	_3dGradients[hash] = ret;
-	return (ret);
+	uint64_t	theta = (hash & 0xFFFFFFFFULL) >> (32 - GRADIENT_3D_BITS);
+	uint64_t	phi = hash >> (64 - GRADIENT_3D_BITS);
+	return (gradients3D[phi * GRADIENT_3D_STEPS + theta]);
 }
 
 uint64_t	Perlin::_hash(int x, int y) const
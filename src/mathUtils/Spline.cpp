@@ -7,6 +7,8 @@ Created on: 24/08/2025
 
 #include <algorithm>
 
+thread_local uint64_t	Spline::_batchEvaluations = 0;
+
 Spline::Spline()
 {
 }
@@ -16,14 +18,20 @@ Spline::Spline(const std::vector<mlm::vec2> &points)
 	setPoints(points);
 }
 
-Spline::Spline(const Spline &src)
+Spline::Spline(const Spline &src):
+	_points(src._points),
+	_resolution(src._resolution),
+	_table(src._table),
+	_tableScale(src._tableScale)
 {
-	setPoints(src._points);
 }
 
 Spline	&Spline::operator=(const Spline &src)
 {
-	setPoints(src._points);
+	_points = src._points;
+	_resolution = src._resolution;
+	_table = src._table;
+	_tableScale = src._tableScale;
 	return (*this);
 }
 
@@ -44,14 +52,53 @@ void	Spline::setPoints(const std::vector<mlm::vec2> &points)
 			return (a.x < b.x);
 		}
 	);
+	_bake();
+}
+
+void	Spline::setResolution(uint64_t resolution)
+{
+	_resolution = resolution;
+	_bake();
+}
+
+uint64_t	Spline::getResolution() const
+{
+	return (_resolution);
 }
 
 float	Spline::evaluate(float t) const
+{
+	if (_table.empty())
+		return (evaluateExact(t));
+	if (t <= _points.front().x)
+		return (_points.front().y);
+	if (t >= _points.back().x)
+		return (_points.back().y);
+
+	float		pos = (t - _points.front().x) * _tableScale;
+	uint64_t	i = std::min(static_cast<uint64_t>(pos), _resolution - 1);
+	float		fraction = pos - static_cast<float>(i);
+	return (_table[i] + (_table[i + 1] - _table[i]) * fraction);
+}
+
+void	Spline::evaluate(const float *in, float *out, size_t count) const
+{
+	for (size_t i = 0; i < count; ++i)
+		out[i] = evaluate(in[i]);
+	_batchEvaluations += count;
+}
+
+uint64_t	Spline::getBatchEvaluations()
+{
+	return (_batchEvaluations);
+}
+
+float	Spline::evaluateExact(float t) const
 {
 	// Return 'extremes' if t falls outside point range
 	if (t < _points.front().x)
 		return (_points.front().y);
-	if (t > _points.back().x)
+	if (t >= _points.back().x)
 		return (_points.back().y);
 
 	// Find appropriate point for t
@@ -80,6 +127,21 @@ bool	Spline::isReady()
 	return (true);
 }
 
+void	Spline::_bake()
+{
+	_table.clear();
+	if (_resolution == 0 || !isReady())
+		return ;
+	float	width = _points.back().x - _points.front().x;
+	if (width <= 0.0f)
+		return ;
+	_tableScale = static_cast<float>(_resolution) / width;
+	_table.resize(_resolution + 1);
+	for (uint64_t i = 0; i < _resolution; ++i)
+		_table[i] = evaluateExact(_points.front().x + width * static_cast<float>(i) / static_cast<float>(_resolution));
+	_table[_resolution] = _points.back().y;
+}
+
 // https://www.mvps.org/directx/articles/catmull/
 float	Spline::_catmullRom(const float y0, const float y1, const float y2, const float y3, const float t) const
 {
@@ -39,7 +39,7 @@ void	Renderer::_initShaders()
 	ShaderManager::loadShader(_ssaoBlurShader, "./resources/shaders/quad.vert", "./resources/shaders/SSAOBlur.frag", [this](){_initSsaoBlurShader();});
 
 	// Draw basic geometry to gBuffers
-	ShaderManager::loadShader(_geometryShader, "./resources/shaders/geometry.vert", "./resources/shaders/geometry.frag");
+	ShaderManager::loadShader(_geometryShader, "./resources/shaders/geometry.vert", "./resources/shaders/geometry.frag", [this](){_initGeometryShader();});
 
 	// Final lighting shader - Combines Light with shadows and SSAO
 	ShaderManager::loadShader(_lightingShader, "./resources/shaders/quad.vert", "./resources/shaders/lighting.frag");
@@ -285,6 +285,21 @@ void	Renderer::_initSsaoSamples()
 	_ssaoShader.set_int("uNoiseTex", 2);
 }
 
+// Block types uTiles in geometry.vert has room for, has to be changed together with the shader
+static constexpr int	SHADER_TILE_TYPES = 6;
+
+void	Renderer::_initGeometryShader()
+{
+	static_assert(Block::TYPE_COUNT == SHADER_TILE_TYPES, "uTiles in geometry.vert has to hold 6 tiles for every block type");
+	Atlas	&atlas = _engine.getAtlas();
+
+	// Chunk vertices only store their block type and face, the shader looks up the atlas tile
+	for (int type = 0; type < Block::TYPE_COUNT; ++type)
+		for (int side = 0; side < 6; ++side)
+			_geometryShader.set_int("uTiles[" + std::to_string(type * 6 + side) + "]", atlas.getTile(static_cast<Block::Type>(type), side));
+	_geometryShader.set_float("uTilePixelWidth", atlas.getTilePixelWidth());
+}
+
 void	Renderer::_initSsaoBlurShader()
 {
 	_ssaoBlurShader.use();
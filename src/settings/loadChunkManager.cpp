@@ -22,6 +22,18 @@ static void	validateSettings(const ChunkManagerDTO &chunkManagerDto)
 		|| (chunkManagerDto.threadCount > UPPER_LIMIT)
 		|| (chunkManagerDto.renderDistance > UPPER_LIMIT))
 		throw std::runtime_error("chunkManager settings can't be larger than " + std::to_string(static_cast<int>(UPPER_LIMIT)));
+	if (chunkManagerDto.unloadMargin < 0.0f || chunkManagerDto.unloadMargin > UPPER_LIMIT)
+		throw std::runtime_error("chunkManager unloadMargin has to be between 0 and " + std::to_string(static_cast<int>(UPPER_LIMIT)));
+	if (chunkManagerDto.unloadCacheSize < 0.0f || chunkManagerDto.unloadCacheSize > 65536.0f)
+		throw std::runtime_error("chunkManager unloadCacheSize has to be between 0 and 65536");
+	if (chunkManagerDto.meshCacheSize < 0.0f || chunkManagerDto.meshCacheSize > 65536.0f)
+		throw std::runtime_error("chunkManager meshCacheSize has to be between 0 and 65536");
+	if (chunkManagerDto.meshSpillSize < 0.0f || chunkManagerDto.meshSpillSize > 65536.0f)
+		throw std::runtime_error("chunkManager meshSpillSize has to be between 0 and 65536");
+	if (chunkManagerDto.chunkPoolSize < 0.0f || chunkManagerDto.chunkPoolSize > 65536.0f)
+		throw std::runtime_error("chunkManager chunkPoolSize has to be between 0 and 65536");
+	if (chunkManagerDto.blockPoolSize < 0.0f || chunkManagerDto.blockPoolSize > 65536.0f)
+		throw std::runtime_error("chunkManager blockPoolSize has to be between 0 and 65536");
 }
 
 ChunkManagerDTO	Settings::loadChunkManager()
@@ -39,6 +51,21 @@ ChunkManagerDTO	Settings::loadChunkManager()
 		chunkManagerDto.maxLoad = root->get("maxLoad")->getNumber();
 		chunkManagerDto.maxGenerate = root->get("maxGenerate")->getNumber();
 		chunkManagerDto.maxMesh = root->get("maxMesh")->getNumber();
+		chunkManagerDto.greedyMeshing = root->get("greedyMeshing")->getBool();
+		chunkManagerDto.saveEdits = root->get("saveEdits")->getBool();
+		chunkManagerDto.savePath = root->get("savePath")->getString();
+		chunkManagerDto.cacheChunks = root->get("cacheChunks")->getBool();
+		chunkManagerDto.mmapReads = root->get("mmapReads")->getBool();
+		chunkManagerDto.unloadMargin = root->get("unloadMargin")->getNumber();
+		chunkManagerDto.unloadCacheSize = root->get("unloadCacheSize")->getNumber();
+		chunkManagerDto.cacheMeshes = root->get("cacheMeshes")->getBool();
+		chunkManagerDto.meshCacheSize = root->get("meshCacheSize")->getNumber();
+		chunkManagerDto.meshCacheSpill = root->get("meshCacheSpill")->getBool();
+		chunkManagerDto.meshSpillSize = root->get("meshSpillSize")->getNumber();
+		chunkManagerDto.chunkPoolSize = root->get("chunkPoolSize")->getNumber();
+		chunkManagerDto.blockPoolSize = root->get("blockPoolSize")->getNumber();
+		chunkManagerDto.hugePages = root->get("hugePages")->getBool();
+		chunkManagerDto.freeMeshVertices = root->get("freeMeshVertices")->getBool();
 
 		validateSettings(chunkManagerDto);
 		return (chunkManagerDto);
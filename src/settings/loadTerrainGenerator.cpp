@@ -38,6 +38,77 @@ static void	loadNoiseSettings(NoiseSettings &target, JSON::NodePtr node)
 		throw std::runtime_error("terrainGenerator: noiseSettings: zoom can't be smaller than 1");
 }
 
+static const std::unordered_map<std::string, DensityNode::Type>	DensityNodeTypes = {
+	{"constant", DensityNode::CONSTANT},
+	{"noise", DensityNode::NOISE},
+	{"spline", DensityNode::SPLINE},
+	{"add", DensityNode::ADD},
+	{"sub", DensityNode::SUB},
+	{"mul", DensityNode::MUL},
+	{"min", DensityNode::MIN},
+	{"max", DensityNode::MAX},
+	{"abs", DensityNode::ABS},
+	{"floor", DensityNode::FLOOR},
+	{"clamp", DensityNode::CLAMP},
+	{"threshold", DensityNode::THRESHOLD},
+	{"select", DensityNode::SELECT},
+};
+
+static void	loadDensityNode(DensityNode &target, const std::string &name, JSON::NodePtr node)
+{
+	std::string	type = node->get("type")->getString();
+	try
+	{
+		target.type = DensityNodeTypes.at(type);
+	}
+	catch(const std::exception& e)
+	{
+		throw std::runtime_error("densityGraph: node `" + name + "` has invalid type `" + type + "`");
+	}
+
+	// Constants and noises have no inputs, the compiler checks the amount of the others
+	switch (target.type)
+	{
+		case DensityNode::CONSTANT:
+			target.value = node->get("value")->getNumber();
+			return ;
+		case DensityNode::NOISE:
+		{
+			target.noise = node->get("noise")->getString();
+			float	seed = node->get("seed")->getNumber();
+			if (seed < 0.0f)
+				throw std::runtime_error("densityGraph: node `" + name + "`: seed can't be negative");
+			target.seed = static_cast<uint64_t>(seed);
+			target.dimensions = static_cast<int>(node->get("dimensions")->getNumber());
+			return ;
+		}
+		case DensityNode::SPLINE:
+			loadSpline(target.spline, node->get("points"));
+			break ;
+		case DensityNode::CLAMP:
+			target.min = node->get("min")->getNumber();
+			target.max = node->get("max")->getNumber();
+			break ;
+		default:
+			break ;
+	}
+	for (JSON::NodePtr input : *node->get("inputs")->getList())
+		target.inputs.push_back(input->getString());
+}
+
+static void	loadDensityGraph(DensityGraph &target, JSON::NodePtr node)
+{
+	JSON::Object	&nodes = *node->get("nodes")->getObject();
+	for (auto [key, val] : nodes)
+		loadDensityNode(target.nodes[key], key, val);
+
+	JSON::NodePtr	outputs = node->get("outputs");
+	target.height = outputs->get("height")->getString();
+	target.sand = outputs->get("sand")->getString();
+	for (JSON::NodePtr cave : *outputs->get("caves")->getList())
+		target.caves.push_back(cave->getString());
+}
+
 static void	validateSettings(const TerrainGeneratorDTO &terrainDto)
 {
 	if (terrainDto.seed < 0.0f)
@@ -48,6 +119,14 @@ static void	validateSettings(const TerrainGeneratorDTO &terrainDto)
 		throw std::runtime_error("terrainGenerator: seaLevel can't be negative");
 	if (terrainDto.seaLevel > static_cast<float>(CHUNK_SIZE_Y))
 		throw std::runtime_error("terrainGenerator: seaLevel can't be larger than " + std::to_string(CHUNK_SIZE_Y));
+	if (terrainDto.latticeStep < 0.0f)
+		throw std::runtime_error("terrainGenerator: latticeStep can't be negative");
+	if (terrainDto.latticeStep > static_cast<float>(CHUNK_SIZE_X))
+		throw std::runtime_error("terrainGenerator: latticeStep can't be larger than " + std::to_string(CHUNK_SIZE_X));
+	if (terrainDto.splineResolution < 0.0f)
+		throw std::runtime_error("terrainGenerator: splineResolution can't be negative");
+	if (terrainDto.splineResolution > 65536.0f)
+		throw std::runtime_error("terrainGenerator: splineResolution can't be larger than 65536");
 }
 
 TerrainGeneratorDTO	Settings::loadTerrainGenerator()
@@ -65,11 +144,14 @@ TerrainGeneratorDTO	Settings::loadTerrainGenerator()
 		terrainDto.caveDiameter = root->get("caveDiameter")->getNumber();
 		terrainDto.sandBeachThreshold = root->get("sandBeachThreshold")->getNumber();
 		terrainDto.sandSeaThreshold = root->get("sandSeaThreshold")->getNumber();
+		terrainDto.latticeStep = root->get("latticeStep")->getNumber();
+		terrainDto.splineResolution = root->get("splineResolution")->getNumber();
 
 		JSON::NodePtr	NoiseSettings = root->get("noiseSettings");
 		loadNoiseSettings(terrainDto.continentalness, NoiseSettings->get("continentalness"));
 		loadNoiseSettings(terrainDto.cave, NoiseSettings->get("cave"));
 		loadNoiseSettings(terrainDto.sand, NoiseSettings->get("sand"));
+		loadDensityGraph(terrainDto.densityGraph, root->get("densityGraph"));
 
 		validateSettings(terrainDto);
 		return (terrainDto);